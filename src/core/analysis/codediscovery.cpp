@@ -0,0 +1,334 @@
+#include "codediscovery.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#include "elfdynamic.h"
+#include "instructiondecoder.h"
+#include "relocationtable.h"
+#include "threadpool.h"
+
+namespace MTC {
+
+    namespace {
+
+        // File backed part of an executable segment, bit indexes of its bytes start at base
+        class CodeRegion {
+        public:
+            uint64_t start;
+            uint64_t end;
+            const char *data;
+            size_t base;
+        };
+
+        // Lock-free set of bit indexes, one bit per byte of code
+        class ConcurrentAddressSet {
+        public:
+            explicit ConcurrentAddressSet(size_t size)
+                : _words(new std::atomic<uint64_t>[(size + 63) / 64]()) {
+            }
+
+            // Returns false if the index was already in the set
+            inline bool insert(size_t index) {
+                auto bit = uint64_t(1) << (index % 64);
+                return !(_words[index / 64].fetch_or(bit, std::memory_order_relaxed) & bit);
+            }
+
+        protected:
+            std::unique_ptr<std::atomic<uint64_t>[]> _words;
+        };
+
+        // Reads a pointer array after applying the relocations that target it, entries that
+        // stay 0 or -1 are placeholders and skipped
+        void readPointerArray(const ElfFile &file, int index,
+                              const std::vector<SectionHeader> &relocations,
+                              std::vector<uint64_t> &addresses) {
+            auto section = file.sectionHeader(index);
+            if (section.dataSize() == 0) {
+                return;
+            }
+            std::vector<char> data(section.dataSize());
+            memcpy(data.data(), section.data(), data.size());
+
+            RelocationImage image;
+            image.data = data.data();
+            image.size = data.size();
+            image.address = section.address();
+            image.byteOrder = file.byteOrder();
+
+            auto arch = file.architecture();
+            for (const auto &rel : relocations) {
+                std::string_view relData(rel.data(), rel.dataSize());
+                switch (rel.type()) {
+                    case SectionHeader::Relocation:
+                    case SectionHeader::RelocationWithAttends:
+                        RelocationTable(rel).apply(arch, image, nullptr, 0);
+                        break;
+                    case SectionHeader::RelativeRelocation:
+                        RelrDecoder(relData, file.elfClass(), file.byteOrder()).apply(arch, image);
+                        break;
+                    default:
+                        AndroidRelocationDecoder(
+                            relData, rel.type() == SectionHeader::AndroidRelocationWithAttends,
+                            file.elfClass())
+                            .apply(arch, image, nullptr, 0);
+                        break;
+                }
+            }
+
+            size_t wordSize = file.elfClass() == ElfFile::Class32 ? 4 : 8;
+            for (size_t pos = 0; pos + wordSize <= data.size(); pos += wordSize) {
+                auto p = data.data() + pos;
+                uint64_t value;
+                if (file.byteOrder() == ByteOrder::BigEndian) {
+                    value = wordSize == 4 ? loadValue<ByteOrder::BigEndian, uint32_t>(p)
+                                          : loadValue<ByteOrder::BigEndian, uint64_t>(p);
+                } else {
+                    value = wordSize == 4 ? loadValue<ByteOrder::LittleEndian, uint32_t>(p)
+                                          : loadValue<ByteOrder::LittleEndian, uint64_t>(p);
+                }
+                auto none = wordSize == 4 ? uint64_t(UINT32_MAX) : UINT64_MAX;
+                if (value != 0 && value != none) {
+                    addresses.push_back(value);
+                }
+            }
+        }
+
+    }
+
+    class CodeDiscovery::Impl {
+    public:
+        AddressSpace space;
+        std::unique_ptr<InstructionDecoder> decoder;
+
+        // Sorted by address
+        std::vector<CodeRegion> regions;
+        size_t codeSize = 0;
+
+        std::vector<uint64_t> roots;
+        std::vector<uint64_t> functions;
+        InstructionArena instructions;
+
+        // State shared by the tasks of one run
+        class Run {
+        public:
+            ThreadPool *pool;
+            ConcurrentAddressSet visited;
+            ConcurrentAddressSet functionStarts;
+
+            std::mutex mutex;
+            std::vector<uint64_t> functions;
+            std::vector<InstructionArena> results;
+
+            Run(ThreadPool *pool, size_t size)
+                : pool(pool), visited(size), functionStarts(size) {
+            }
+        };
+
+        inline const CodeRegion *findRegion(uint64_t address) const;
+
+        void startFunction(Run &run, uint64_t address) const;
+        void decodeFunction(Run &run, uint64_t address) const;
+    };
+
+    inline const CodeRegion *CodeDiscovery::Impl::findRegion(uint64_t address) const {
+        auto it = std::upper_bound(
+            regions.begin(), regions.end(), address,
+            [](uint64_t address, const CodeRegion &region) { return address < region.start; });
+        if (it == regions.begin() || address >= (it - 1)->end) {
+            return nullptr;
+        }
+        return &*(it - 1);
+    }
+
+    void CodeDiscovery::Impl::startFunction(Run &run, uint64_t address) const {
+        auto region = findRegion(address);
+        if (!region || !run.functionStarts.insert(region->base + (address - region->start))) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(run.mutex);
+            run.functions.push_back(address);
+        }
+        run.pool->start([this, &run, address]() { decodeFunction(run, address); });
+    }
+
+    void CodeDiscovery::Impl::decodeFunction(Run &run, uint64_t address) const {
+        InstructionArena arena;
+        std::vector<uint64_t> pending = {address};
+        while (!pending.empty()) {
+            uint64_t pc = pending.back();
+            pending.pop_back();
+
+            // Straight-line run up to the next instruction that does not fall through, or to
+            // the first one another path has already claimed
+            const CodeRegion *region = nullptr;
+            while (true) {
+                if (!region || pc < region->start || pc >= region->end) {
+                    region = findRegion(pc);
+                    if (!region) {
+                        break;
+                    }
+                }
+                auto offset = pc - region->start;
+                if (!run.visited.insert(region->base + offset)) {
+                    break;
+                }
+
+                auto &insn = arena.append();
+                decoder->decodeOne(region->data + offset, region->end - pc, pc, insn);
+                if (insn.flags & Instruction::DirectTarget) {
+                    if (insn.flow == Instruction::Call) {
+                        startFunction(run, insn.target);
+                    } else {
+                        pending.push_back(insn.target);
+                    }
+                }
+
+                auto flow = insn.flow;
+                if (flow == Instruction::Jump || flow == Instruction::IndirectJump ||
+                    flow == Instruction::Return || flow == Instruction::Trap ||
+                    flow == Instruction::Invalid) {
+                    break;
+                }
+                pc = insn.end();
+            }
+        }
+
+        if (!arena.isEmpty()) {
+            std::lock_guard<std::mutex> lock(run.mutex);
+            run.results.push_back(std::move(arena));
+        }
+    }
+
+    CodeDiscovery::CodeDiscovery() : _impl(std::make_unique<Impl>()) {
+    }
+
+    CodeDiscovery::CodeDiscovery(const ElfFile &file) : CodeDiscovery() {
+        if (!file.isValid()) {
+            return;
+        }
+        auto &impl = *_impl;
+        impl.decoder = InstructionDecoder::create(file.architecture());
+        impl.space = file.addressSpace();
+        for (int i = 0; i < impl.space.count(); ++i) {
+            auto span = impl.space.span(i);
+            if (span.kind != AddressSpan::FileBacked || !span.data ||
+                !(span.attributes & ProgramHeader::Executable)) {
+                continue;
+            }
+            impl.regions.push_back({span.address, span.address + span.size, span.data,
+                                    impl.codeSize});
+            impl.codeSize += span.size;
+        }
+
+        // Roots
+        auto &roots = impl.roots;
+        if (file.entryPoint()) {
+            roots.push_back(file.entryPoint());
+        }
+
+        std::vector<SectionHeader> relocations;
+        for (int i = 0; i < file.sectionHeaderCount(); ++i) {
+            auto section = file.sectionHeader(i);
+            switch (section.type()) {
+                case SectionHeader::SymbolTable:
+                case SectionHeader::DynamicSymbol: {
+                    auto table = section.asSymbolTable();
+                    for (int j = 0; j < table.count(); ++j) {
+                        const auto &sym = table.symbol(j);
+                        auto type = ELF64_ST_TYPE(sym.st_info);
+                        if ((type == STT_FUNC || type == STT_GNU_IFUNC) &&
+                            sym.st_shndx != SHN_UNDEF && sym.st_value != 0) {
+                            roots.push_back(sym.st_value);
+                        }
+                    }
+                    break;
+                }
+                case SectionHeader::Relocation:
+                case SectionHeader::RelocationWithAttends:
+                case SectionHeader::RelativeRelocation:
+                case SectionHeader::AndroidRelocation:
+                case SectionHeader::AndroidRelocationWithAttends:
+                    relocations.push_back(section);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        ElfDynamic dynamic(file);
+        for (auto tag : {DT_INIT, DT_FINI}) {
+            if (dynamic.contains(tag)) {
+                roots.push_back(dynamic.value(tag));
+            }
+        }
+        for (auto name : {".init_array", ".fini_array"}) {
+            auto index = file.findSection(name);
+            if (index >= 0) {
+                readPointerArray(file, index, relocations, roots);
+            }
+        }
+
+        std::sort(roots.begin(), roots.end());
+        roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+    }
+
+    CodeDiscovery::~CodeDiscovery() = default;
+
+    CodeDiscovery::CodeDiscovery(CodeDiscovery &&other) noexcept = default;
+
+    CodeDiscovery &CodeDiscovery::operator=(CodeDiscovery &&other) noexcept = default;
+
+    bool CodeDiscovery::isValid() const {
+        return _impl && _impl->decoder && !_impl->regions.empty();
+    }
+
+    const std::vector<uint64_t> &CodeDiscovery::roots() const {
+        return _impl->roots;
+    }
+
+    void CodeDiscovery::addRoot(uint64_t address) {
+        _impl->roots.push_back(address);
+    }
+
+    void CodeDiscovery::run(int threads) {
+        if (!isValid()) {
+            return;
+        }
+        auto &impl = *_impl;
+        impl.functions.clear();
+        impl.instructions.clear();
+
+        ThreadPool pool(threads);
+        Impl::Run run(&pool, impl.codeSize);
+        for (auto address : impl.roots) {
+            impl.startFunction(run, address);
+        }
+        pool.waitForDone();
+
+        size_t count = 0;
+        for (const auto &result : run.results) {
+            count += result.count();
+        }
+        impl.instructions.reserve(count);
+        for (const auto &result : run.results) {
+            impl.instructions.append(result);
+        }
+        impl.instructions.sortByAddress();
+
+        impl.functions = std::move(run.functions);
+        std::sort(impl.functions.begin(), impl.functions.end());
+    }
+
+    const std::vector<uint64_t> &CodeDiscovery::functions() const {
+        return _impl->functions;
+    }
+
+    const InstructionArena &CodeDiscovery::instructions() const {
+        return _impl->instructions;
+    }
+
+}
@@ -0,0 +1,50 @@
+#ifndef CODEDISCOVERY_H
+#define CODEDISCOVERY_H
+
+#include <memory>
+#include <vector>
+
+#include <mtccore/elffile.h>
+#include <mtccore/instruction.h>
+
+namespace MTC {
+
+    // Recursive descent over the executable segments of a file. Every function is decoded by its
+    // own task on a work-stealing pool, and tasks share one set of visited addresses, so no
+    // instruction is decoded twice however many paths reach it.
+    class MTC_CORE_EXPORT CodeDiscovery {
+    public:
+        CodeDiscovery();
+        explicit CodeDiscovery(const ElfFile &file);
+        ~CodeDiscovery();
+
+        CodeDiscovery(CodeDiscovery &&other) noexcept;
+        CodeDiscovery &operator=(CodeDiscovery &&other) noexcept;
+
+    public:
+        // False if the architecture has no decoder or the file has no executable segment
+        bool isValid() const;
+
+        // Initially the entry point, the function symbols of every symbol table, DT_INIT,
+        // DT_FINI and the entries of .init_array and .fini_array
+        const std::vector<uint64_t> &roots() const;
+        void addRoot(uint64_t address);
+
+        // Decodes the code reachable from the roots, direct call targets become functions of
+        // their own. Replaces the results of a previous run.
+        void run(int threads = 0);
+
+        // Start addresses of the decoded functions, sorted
+        const std::vector<uint64_t> &functions() const;
+
+        // Every decoded instruction, sorted by address
+        const InstructionArena &instructions() const;
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // CODEDISCOVERY_H
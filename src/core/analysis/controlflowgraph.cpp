@@ -0,0 +1,137 @@
+#include "controlflowgraph.h"
+
+#include <algorithm>
+
+namespace MTC {
+
+    static inline bool isDirectBranch(const Instruction &insn) {
+        return (insn.flags & Instruction::DirectTarget) &&
+               (insn.flow == Instruction::Jump || insn.flow == Instruction::ConditionalJump);
+    }
+
+    static inline bool fallsThrough(Instruction::Flow flow) {
+        return flow == Instruction::Sequential || flow == Instruction::ConditionalJump ||
+               flow == Instruction::Call || flow == Instruction::IndirectCall;
+    }
+
+    ControlFlowGraph::ControlFlowGraph() = default;
+
+    ControlFlowGraph::ControlFlowGraph(const InstructionArena &instructions,
+                                       const std::vector<uint64_t> &functions) {
+        std::vector<uint64_t> targets;
+        for (const auto &insn : instructions) {
+            if (isDirectBranch(insn)) {
+                targets.push_back(insn.target);
+            }
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+        // A block starts at a function entry, a branch target or after a terminator or a gap
+        std::vector<uint64_t> branchTargets;
+        auto addBlock = [&](const Instruction &first, const Instruction &last) {
+            uint8_t flags = 0;
+            if (std::binary_search(functions.begin(), functions.end(), first.address)) {
+                flags |= FunctionEntry;
+            }
+            if (std::binary_search(targets.begin(), targets.end(), first.address)) {
+                flags |= BranchTarget;
+            }
+            appendBlock(first.address, last.end(), last.flow, flags);
+            branchTargets.push_back(isDirectBranch(last) ? last.target : 0);
+        };
+
+        auto n = instructions.count();
+        size_t first = 0;
+        for (size_t i = 1; i < n; ++i) {
+            const auto &prev = instructions.at(i - 1);
+            const auto &insn = instructions.at(i);
+            if (prev.endsBlock() || prev.end() != insn.address ||
+                std::binary_search(targets.begin(), targets.end(), insn.address) ||
+                std::binary_search(functions.begin(), functions.end(), insn.address)) {
+                addBlock(instructions.at(first), prev);
+                first = i;
+            }
+        }
+        if (n > 0) {
+            addBlock(instructions.at(first), instructions.at(n - 1));
+        }
+
+        // Blocks are in address order, so successors are found by exact start address
+        auto blocks = count();
+        _order.resize(blocks);
+        for (uint32_t i = 0; i < blocks; ++i) {
+            _order[i] = i;
+            if (fallsThrough(_terminators[i]) && i + 1 < blocks && _starts[i + 1] == _ends[i]) {
+                _fallThroughs[i] = i + 1;
+            }
+            if (branchTargets[i]) {
+                auto it = std::lower_bound(_starts.begin(), _starts.end(), branchTargets[i]);
+                if (it != _starts.end() && *it == branchTargets[i]) {
+                    _branches[i] = uint32_t(it - _starts.begin());
+                }
+            }
+        }
+    }
+
+    ControlFlowGraph::~ControlFlowGraph() = default;
+
+    uint32_t ControlFlowGraph::findBlock(uint64_t address) const {
+        auto it = std::upper_bound(
+            _order.begin(), _order.end(), address,
+            [this](uint64_t address, uint32_t block) { return address < _starts[block]; });
+        if (it == _order.begin()) {
+            return NoBlock;
+        }
+        auto block = *(it - 1);
+        return address < _ends[block] ? block : NoBlock;
+    }
+
+    uint32_t ControlFlowGraph::splitBlock(uint64_t address) {
+        auto block = findBlock(address);
+        if (block == NoBlock || _starts[block] == address) {
+            return block;
+        }
+
+        auto tail = appendBlock(address, _ends[block], _terminators[block], 0);
+        _fallThroughs[tail] = _fallThroughs[block];
+        _branches[tail] = _branches[block];
+
+        _ends[block] = address;
+        _terminators[block] = Instruction::Sequential;
+        _fallThroughs[block] = tail;
+        _branches[block] = NoBlock;
+
+        // Existing indexes stay valid, only the order moves
+        auto pos = std::upper_bound(
+            _order.begin(), _order.end(), address,
+            [this](uint64_t address, uint32_t block) { return address < _starts[block]; });
+        _order.insert(pos, tail);
+        return tail;
+    }
+
+    uint32_t ControlFlowGraph::addBranch(uint32_t block, uint64_t target) {
+        // A branch into its own block moves to the tail along with the terminator
+        bool inside = target > _starts[block] && target < _ends[block];
+        auto targetBlock = splitBlock(target);
+        if (targetBlock == NoBlock) {
+            return NoBlock;
+        }
+        _branches[inside ? targetBlock : block] = targetBlock;
+        _flags[targetBlock] |= BranchTarget;
+        return targetBlock;
+    }
+
+    uint32_t ControlFlowGraph::appendBlock(uint64_t start, uint64_t end,
+                                           Instruction::Flow terminator, uint8_t flags) {
+        auto index = uint32_t(_starts.size());
+        _starts.push_back(start);
+        _ends.push_back(end);
+        _terminators.push_back(terminator);
+        _flags.push_back(flags);
+        _fallThroughs.push_back(NoBlock);
+        _branches.push_back(NoBlock);
+        return index;
+    }
+
+}
@@ -0,0 +1,141 @@
+#ifndef CONTROLFLOWGRAPH_H
+#define CONTROLFLOWGRAPH_H
+
+#include <vector>
+
+#include <mtccore/instruction.h>
+
+namespace MTC {
+
+    // Basic blocks and their intraprocedural edges in structure-of-arrays form. Blocks are
+    // referred to by 32-bit indexes that stay valid when blocks are split, every block has at
+    // most a fall-through and a direct branch successor, and calls do not make edges.
+    class MTC_CORE_EXPORT ControlFlowGraph {
+    public:
+        ControlFlowGraph();
+
+        // Builds the blocks of instructions sorted by address, such as the result of
+        // CodeDiscovery, with the given sorted function entries
+        ControlFlowGraph(const InstructionArena &instructions,
+                         const std::vector<uint64_t> &functions);
+        ~ControlFlowGraph();
+
+        enum BlockFlag : uint8_t {
+            FunctionEntry = 0x1,
+            // A direct branch of another block targets the start
+            BranchTarget = 0x2,
+        };
+
+        static constexpr const uint32_t NoBlock = UINT32_MAX;
+
+    public:
+        inline uint32_t count() const;
+
+        inline uint64_t start(uint32_t block) const;
+        inline uint64_t end(uint32_t block) const;
+
+        // Flow of the last instruction of the block
+        inline Instruction::Flow terminator(uint32_t block) const;
+        inline uint8_t flags(uint32_t block) const;
+
+        // Successors, or NoBlock
+        inline uint32_t fallThrough(uint32_t block) const;
+        inline uint32_t branch(uint32_t block) const;
+
+        // Parallel arrays indexed by block
+        inline const uint64_t *starts() const;
+        inline const uint64_t *ends() const;
+        inline const Instruction::Flow *terminators() const;
+        inline const uint8_t *flagArray() const;
+        inline const uint32_t *fallThroughs() const;
+        inline const uint32_t *branches() const;
+
+        // Block indexes sorted by start address
+        inline const std::vector<uint32_t> &order() const;
+
+        // Block containing the address, or NoBlock. Blocks of overlapping instruction streams,
+        // such as a jump over a lock prefix, can overlap and the one starting last wins.
+        uint32_t findBlock(uint64_t address) const;
+
+        // Makes the address, which must be an instruction boundary, the start of a block. The
+        // tail of the containing block becomes a new block that takes over its successors and
+        // terminator, and the head falls through to it. Returns the block starting at the
+        // address, or NoBlock if no block contains it.
+        uint32_t splitBlock(uint64_t address);
+
+        // Sets the branch successor of a block, splitting the block that contains the target
+        uint32_t addBranch(uint32_t block, uint64_t target);
+
+    protected:
+        std::vector<uint64_t> _starts;
+        std::vector<uint64_t> _ends;
+        std::vector<Instruction::Flow> _terminators;
+        std::vector<uint8_t> _flags;
+        std::vector<uint32_t> _fallThroughs;
+        std::vector<uint32_t> _branches;
+
+        std::vector<uint32_t> _order;
+
+        uint32_t appendBlock(uint64_t start, uint64_t end, Instruction::Flow terminator,
+                             uint8_t flags);
+    };
+
+    inline uint32_t ControlFlowGraph::count() const {
+        return uint32_t(_starts.size());
+    }
+
+    inline uint64_t ControlFlowGraph::start(uint32_t block) const {
+        return _starts[block];
+    }
+
+    inline uint64_t ControlFlowGraph::end(uint32_t block) const {
+        return _ends[block];
+    }
+
+    inline Instruction::Flow ControlFlowGraph::terminator(uint32_t block) const {
+        return _terminators[block];
+    }
+
+    inline uint8_t ControlFlowGraph::flags(uint32_t block) const {
+        return _flags[block];
+    }
+
+    inline uint32_t ControlFlowGraph::fallThrough(uint32_t block) const {
+        return _fallThroughs[block];
+    }
+
+    inline uint32_t ControlFlowGraph::branch(uint32_t block) const {
+        return _branches[block];
+    }
+
+    inline const uint64_t *ControlFlowGraph::starts() const {
+        return _starts.data();
+    }
+
+    inline const uint64_t *ControlFlowGraph::ends() const {
+        return _ends.data();
+    }
+
+    inline const Instruction::Flow *ControlFlowGraph::terminators() const {
+        return _terminators.data();
+    }
+
+    inline const uint8_t *ControlFlowGraph::flagArray() const {
+        return _flags.data();
+    }
+
+    inline const uint32_t *ControlFlowGraph::fallThroughs() const {
+        return _fallThroughs.data();
+    }
+
+    inline const uint32_t *ControlFlowGraph::branches() const {
+        return _branches.data();
+    }
+
+    inline const std::vector<uint32_t> &ControlFlowGraph::order() const {
+        return _order;
+    }
+
+}
+
+#endif // CONTROLFLOWGRAPH_H
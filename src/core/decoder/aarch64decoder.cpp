@@ -0,0 +1,239 @@
+#include "aarch64decoder.h"
+
+#include <algorithm>
+
+#include "byteorder.h"
+
+namespace MTC {
+
+    namespace {
+
+        class Pattern {
+        public:
+            uint32_t mask;
+            uint32_t value;
+            AArch64Decoder::Class result;
+        };
+
+        // Matched in order, a later pattern overrides an earlier one that also matches
+        constexpr Pattern Patterns[] = {
+            {0x0A000000, 0x08000000, AArch64Decoder::LoadStore},
+            {0x3B000000, 0x18000000, AArch64Decoder::LoadLiteral},
+            {0x1F000000, 0x10000000, AArch64Decoder::AddressPCRelative},
+            {0x7C000000, 0x14000000, AArch64Decoder::BranchImmediate},
+            {0x7E000000, 0x34000000, AArch64Decoder::CompareBranch},
+            {0x7E000000, 0x36000000, AArch64Decoder::TestBranch},
+            {0xFF000000, 0x54000000, AArch64Decoder::BranchConditional},
+            {0xFF000000, 0xD4000000, AArch64Decoder::Exception},
+            {0xFFC00000, 0xD5000000, AArch64Decoder::System},
+            {0xFE000000, 0xD6000000, AArch64Decoder::BranchRegister},
+            {0x9E000000, 0x00000000, AArch64Decoder::Undefined},
+            {0x1E000000, 0x02000000, AArch64Decoder::Undefined},
+            {0x1E000000, 0x06000000, AArch64Decoder::Undefined},
+        };
+
+        using Batch = uint32_t[AArch64Decoder::BatchSize];
+
+        // Every pass is a compare and a select over the whole batch without branches, which
+        // optimizing compilers turn into vector instructions
+        inline void classifyBatch(const Batch &words, AArch64Decoder::Class *classes) {
+            Batch result = {};
+            for (const auto &pattern : Patterns) {
+                for (int i = 0; i < AArch64Decoder::BatchSize; ++i) {
+                    uint32_t match = -uint32_t((words[i] & pattern.mask) == pattern.value);
+                    result[i] = (result[i] & ~match) | (pattern.result & match);
+                }
+            }
+            for (int i = 0; i < AArch64Decoder::BatchSize; ++i) {
+                classes[i] = AArch64Decoder::Class(result[i]);
+            }
+        }
+
+        // Reads count words, the rest of the batch is zero
+        inline void loadBatch(const char *data, size_t count, Batch &words) {
+            memcpy(words, data, count * AArch64Decoder::InstructionSize);
+            std::fill(words + count, words + AArch64Decoder::BatchSize, 0);
+            toHostOrderArray<ByteOrder::LittleEndian>(words, AArch64Decoder::BatchSize);
+        }
+
+        inline int64_t signExtend(uint32_t value, int bits) {
+            return int64_t(uint64_t(value) << (64 - bits)) >> (64 - bits);
+        }
+
+        inline int64_t branchOffset(uint32_t word, int shift, int bits) {
+            return signExtend((word >> shift) & ((1u << bits) - 1), bits) * 4;
+        }
+
+        inline void decodeWord(uint32_t word, AArch64Decoder::Class cls, uint64_t address,
+                               Instruction &insn) {
+            insn.address = address;
+            insn.target = 0;
+            insn.opcode = word;
+            insn.length = AArch64Decoder::InstructionSize;
+            insn.flow = Instruction::Sequential;
+            insn.flags = 0;
+
+            switch (cls) {
+                case AArch64Decoder::Other:
+                    break;
+                case AArch64Decoder::BranchImmediate:
+                    insn.flow = (word & 0x80000000) ? Instruction::Call : Instruction::Jump;
+                    insn.target = address + branchOffset(word, 0, 26);
+                    insn.flags = Instruction::DirectTarget;
+                    break;
+                case AArch64Decoder::BranchConditional:
+                    // AL and NV always branch
+                    insn.flow = (word & 0xE) == 0xE ? Instruction::Jump
+                                                    : Instruction::ConditionalJump;
+                    insn.target = address + branchOffset(word, 5, 19);
+                    insn.flags = Instruction::DirectTarget;
+                    break;
+                case AArch64Decoder::CompareBranch:
+                    insn.flow = Instruction::ConditionalJump;
+                    insn.target = address + branchOffset(word, 5, 19);
+                    insn.flags = Instruction::DirectTarget;
+                    break;
+                case AArch64Decoder::TestBranch:
+                    insn.flow = Instruction::ConditionalJump;
+                    insn.target = address + branchOffset(word, 5, 14);
+                    insn.flags = Instruction::DirectTarget;
+                    break;
+                case AArch64Decoder::BranchRegister: {
+                    switch ((word >> 21) & 0xF) {
+                        case 0:
+                        case 8:
+                            insn.flow = Instruction::IndirectJump;
+                            break;
+                        case 1:
+                        case 9:
+                            insn.flow = Instruction::IndirectCall;
+                            break;
+                        case 2:
+                        case 4:
+                        case 5:
+                            insn.flow = Instruction::Return;
+                            break;
+                        default:
+                            insn.flow = Instruction::Invalid;
+                            break;
+                    }
+                    break;
+                }
+                case AArch64Decoder::Exception: {
+                    switch ((word >> 21) & 0x7) {
+                        case 0:
+                        case 5:
+                            insn.flags = AArch64Decoder::SystemControl;
+                            break;
+                        case 1:
+                        case 2:
+                            insn.flow = Instruction::Trap;
+                            break;
+                        default:
+                            insn.flow = Instruction::Invalid;
+                            break;
+                    }
+                    break;
+                }
+                case AArch64Decoder::System:
+                    insn.flags = AArch64Decoder::SystemControl;
+                    break;
+                case AArch64Decoder::AddressPCRelative: {
+                    auto offset = signExtend(((word >> 3) & 0x1FFFFC) | ((word >> 29) & 0x3), 21);
+                    if (word & 0x80000000) {
+                        insn.target = (address & ~uint64_t(0xFFF)) + (uint64_t(offset) << 12);
+                    } else {
+                        insn.target = address + offset;
+                    }
+                    insn.flags = Instruction::PCRelative;
+                    break;
+                }
+                case AArch64Decoder::LoadLiteral:
+                    insn.target = address + branchOffset(word, 5, 19);
+                    insn.flags = Instruction::PCRelative | AArch64Decoder::Memory;
+                    break;
+                case AArch64Decoder::LoadStore:
+                    insn.flags = AArch64Decoder::Memory;
+                    break;
+                case AArch64Decoder::Undefined:
+                    insn.flow = (word >> 16) == 0 ? Instruction::Trap : Instruction::Invalid;
+                    break;
+            }
+        }
+
+        inline void setTruncated(Instruction &insn, uint64_t address, size_t size) {
+            insn.address = address;
+            insn.target = 0;
+            insn.opcode = 0;
+            insn.length = uint8_t(size);
+            insn.flow = Instruction::Invalid;
+            insn.flags = 0;
+        }
+
+    }
+
+    AArch64Decoder::AArch64Decoder() : InstructionDecoder(ElfFile::AArch64) {
+    }
+
+    AArch64Decoder::~AArch64Decoder() = default;
+
+    bool AArch64Decoder::decodeOne(const char *data, size_t size, uint64_t address,
+                                   Instruction &insn) const {
+        if (size < InstructionSize) {
+            setTruncated(insn, address, size);
+            return false;
+        }
+        auto word = loadValue<ByteOrder::LittleEndian, uint32_t>(data);
+        decodeWord(word, classify(word), address, insn);
+        return insn.flow != Instruction::Invalid;
+    }
+
+    size_t AArch64Decoder::decode(const char *data, size_t size, uint64_t address,
+                                  InstructionArena &arena) const {
+        size_t words = size / InstructionSize;
+        Batch batch;
+        Class classes[BatchSize];
+        for (size_t pos = 0; pos < words; pos += BatchSize) {
+            size_t count = std::min<size_t>(BatchSize, words - pos);
+            loadBatch(data + pos * InstructionSize, count, batch);
+            classifyBatch(batch, classes);
+            for (size_t i = 0; i < count; ++i) {
+                decodeWord(batch[i], classes[i], address + (pos + i) * InstructionSize,
+                           arena.append());
+            }
+        }
+
+        // Trailing bytes that do not fill a word
+        size_t rest = size % InstructionSize;
+        if (rest) {
+            setTruncated(arena.append(), address + words * InstructionSize, rest);
+        }
+        return words + (rest ? 1 : 0);
+    }
+
+    void AArch64Decoder::classify(const char *data, size_t count, Class *classes) {
+        Batch batch;
+        for (size_t pos = 0; pos < count; pos += BatchSize) {
+            size_t n = std::min<size_t>(BatchSize, count - pos);
+            loadBatch(data + pos * InstructionSize, n, batch);
+            if (n == BatchSize) {
+                classifyBatch(batch, classes + pos);
+            } else {
+                Class rest[BatchSize];
+                classifyBatch(batch, rest);
+                std::copy(rest, rest + n, classes + pos);
+            }
+        }
+    }
+
+    AArch64Decoder::Class AArch64Decoder::classify(uint32_t word) {
+        auto result = Other;
+        for (const auto &pattern : Patterns) {
+            if ((word & pattern.mask) == pattern.value) {
+                result = pattern.result;
+            }
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,66 @@
+#ifndef AARCH64DECODER_H
+#define AARCH64DECODER_H
+
+#include <mtccore/instructiondecoder.h>
+
+namespace MTC {
+
+    // Decoder of A64 code. Instructions are fixed little-endian words, so a section is first
+    // classified in batches of words by mask and compare passes, and only the classes that carry
+    // a branch or address operand are decoded further.
+    //
+    // Opcode layout: the instruction word.
+    class MTC_CORE_EXPORT AArch64Decoder : public InstructionDecoder {
+    public:
+        AArch64Decoder();
+        ~AArch64Decoder();
+
+        enum Class : uint8_t {
+            Other,
+            // B and BL, imm26
+            BranchImmediate,
+            // B.cond and BC.cond, imm19
+            BranchConditional,
+            // CBZ and CBNZ, imm19
+            CompareBranch,
+            // TBZ and TBNZ, imm14
+            TestBranch,
+            // BR, BLR, RET, ERET, DRPS and their pointer authentication forms
+            BranchRegister,
+            // SVC, HVC, SMC, BRK, HLT and DCPS
+            Exception,
+            // Hints, barriers, MSR and MRS, SYS and SYSL
+            System,
+            // ADR and ADRP
+            AddressPCRelative,
+            // LDR, LDRSW and PRFM with a literal address
+            LoadLiteral,
+            LoadStore,
+            // UDF and the rest of the reserved space
+            Undefined,
+        };
+
+        enum Flag : uint16_t {
+            Memory = Instruction::ArchitectureFlag,
+            SystemControl = Memory << 1,
+        };
+
+        static constexpr const int InstructionSize = 4;
+
+        // Number of words classified by one pass
+        static constexpr const int BatchSize = 16;
+
+    public:
+        bool decodeOne(const char *data, size_t size, uint64_t address,
+                       Instruction &insn) const override;
+        size_t decode(const char *data, size_t size, uint64_t address,
+                      InstructionArena &arena) const override;
+
+        // Classifies count words at data, which needs no alignment
+        static void classify(const char *data, size_t count, Class *classes);
+        static Class classify(uint32_t word);
+    };
+
+}
+
+#endif // AARCH64DECODER_H
@@ -0,0 +1,471 @@
+#include "amd64decoder.h"
+
+#include <algorithm>
+#include <array>
+
+#include "byteorder.h"
+
+namespace MTC {
+
+    namespace {
+
+        enum Operand : uint8_t {
+            NoOperand,
+            Ib,
+            Iw,
+            Iz,
+            Iv,
+            Id,
+            IwIb,
+            Moffs,
+            Jb,
+            Jz,
+            // ib or iz for the TEST forms of group 3 (F6/F7 /0 and /1)
+            Group3,
+        };
+
+        class OpcodeInfo {
+        public:
+            Operand operand = NoOperand;
+            bool modrm = false;
+            bool invalid = false;
+            Instruction::Flow flow = Instruction::Sequential;
+        };
+
+        using OpcodeTable = std::array<OpcodeInfo, 256>;
+
+        constexpr OpcodeInfo M{NoOperand, true};
+        constexpr OpcodeInfo MIb{Ib, true};
+        constexpr OpcodeInfo MIz{Iz, true};
+        constexpr OpcodeInfo Bad{NoOperand, false, true};
+
+        constexpr void fill(OpcodeTable &table, int first, int last, OpcodeInfo info) {
+            for (int i = first; i <= last; ++i) {
+                table[i] = info;
+            }
+        }
+
+        // Prefixes, REX and the escapes to other maps are consumed before the lookup
+        constexpr OpcodeTable makeLegacyMap() {
+            OpcodeTable t{};
+            for (int base = 0; base < 0x40; base += 8) {
+                fill(t, base, base + 3, M);
+                t[base + 4] = {Ib};
+                t[base + 5] = {Iz};
+                fill(t, base + 6, base + 7, Bad);
+            }
+            fill(t, 0x60, 0x62, Bad);
+            t[0x63] = M;
+            t[0x68] = {Iz};
+            t[0x69] = MIz;
+            t[0x6A] = {Ib};
+            t[0x6B] = MIb;
+            fill(t, 0x70, 0x7F, {Jb, false, false, Instruction::ConditionalJump});
+            t[0x80] = MIb;
+            t[0x81] = MIz;
+            t[0x82] = Bad;
+            t[0x83] = MIb;
+            fill(t, 0x84, 0x8F, M);
+            t[0x9A] = Bad;
+            fill(t, 0xA0, 0xA3, {Moffs});
+            t[0xA8] = {Ib};
+            t[0xA9] = {Iz};
+            fill(t, 0xB0, 0xB7, {Ib});
+            fill(t, 0xB8, 0xBF, {Iv});
+            fill(t, 0xC0, 0xC1, MIb);
+            t[0xC2] = {Iw, false, false, Instruction::Return};
+            t[0xC3] = {NoOperand, false, false, Instruction::Return};
+            t[0xC6] = MIb;
+            t[0xC7] = MIz;
+            t[0xC8] = {IwIb};
+            t[0xCA] = {Iw, false, false, Instruction::Return};
+            t[0xCB] = {NoOperand, false, false, Instruction::Return};
+            t[0xCC] = {NoOperand, false, false, Instruction::Trap};
+            t[0xCD] = {Ib};
+            t[0xCE] = Bad;
+            t[0xCF] = {NoOperand, false, false, Instruction::Return};
+            fill(t, 0xD0, 0xD3, M);
+            fill(t, 0xD4, 0xD6, Bad);
+            fill(t, 0xD8, 0xDF, M);
+            fill(t, 0xE0, 0xE3, {Jb, false, false, Instruction::ConditionalJump});
+            fill(t, 0xE4, 0xE7, {Ib});
+            t[0xE8] = {Jz, false, false, Instruction::Call};
+            t[0xE9] = {Jz, false, false, Instruction::Jump};
+            t[0xEA] = Bad;
+            t[0xEB] = {Jb, false, false, Instruction::Jump};
+            t[0xF1] = {NoOperand, false, false, Instruction::Trap};
+            t[0xF4] = {NoOperand, false, false, Instruction::Trap};
+            fill(t, 0xF6, 0xF7, {Group3, true});
+            fill(t, 0xFE, 0xFF, M);
+            return t;
+        }
+
+        constexpr OpcodeTable makeMap0F() {
+            OpcodeTable t{};
+            fill(t, 0x00, 0x03, M);
+            t[0x04] = Bad;
+            t[0x07] = {NoOperand, false, false, Instruction::Return};
+            t[0x0A] = Bad;
+            t[0x0B] = {NoOperand, false, false, Instruction::Trap};
+            t[0x0C] = Bad;
+            t[0x0D] = M;
+            // 3DNow! opcodes are a ModRM form followed by a suffix byte
+            t[0x0F] = MIb;
+            fill(t, 0x10, 0x2F, M);
+            fill(t, 0x24, 0x27, Bad);
+            t[0x35] = {NoOperand, false, false, Instruction::Return};
+            t[0x36] = Bad;
+            t[0x39] = Bad;
+            fill(t, 0x3B, 0x3F, Bad);
+            fill(t, 0x40, 0x7F, M);
+            fill(t, 0x70, 0x73, MIb);
+            t[0x77] = {};
+            fill(t, 0x7A, 0x7B, Bad);
+            fill(t, 0x80, 0x8F, {Jz, false, false, Instruction::ConditionalJump});
+            fill(t, 0x90, 0x9F, M);
+            t[0xA3] = M;
+            t[0xA4] = MIb;
+            t[0xA5] = M;
+            fill(t, 0xA6, 0xA7, Bad);
+            t[0xAB] = M;
+            t[0xAC] = MIb;
+            fill(t, 0xAD, 0xB8, M);
+            t[0xB9] = {NoOperand, true, false, Instruction::Trap};
+            t[0xBA] = MIb;
+            fill(t, 0xBB, 0xC1, M);
+            t[0xC2] = MIb;
+            t[0xC3] = M;
+            fill(t, 0xC4, 0xC6, MIb);
+            t[0xC7] = M;
+            fill(t, 0xD0, 0xFE, M);
+            t[0xFF] = {NoOperand, true, false, Instruction::Trap};
+            return t;
+        }
+
+        // Maps reached through VEX, EVEX or XOP, none of them has branches or register-only forms
+        constexpr OpcodeTable makeExtendedMap(int map) {
+            OpcodeTable t{};
+            switch (map) {
+                case AMD64Decoder::Map0F:
+                    fill(t, 0x00, 0xFF, M);
+                    fill(t, 0x70, 0x73, MIb);
+                    t[0x77] = {};
+                    t[0xC2] = MIb;
+                    fill(t, 0xC4, 0xC6, MIb);
+                    break;
+                case AMD64Decoder::Map0F38:
+                case AMD64Decoder::EvexMap5:
+                case AMD64Decoder::EvexMap6:
+                case AMD64Decoder::XopMap9:
+                    fill(t, 0x00, 0xFF, M);
+                    break;
+                case AMD64Decoder::Map0F3A:
+                case AMD64Decoder::XopMap8:
+                    fill(t, 0x00, 0xFF, MIb);
+                    break;
+                case AMD64Decoder::XopMapA:
+                    fill(t, 0x00, 0xFF, {Id, true});
+                    break;
+                default:
+                    fill(t, 0x00, 0xFF, Bad);
+                    break;
+            }
+            return t;
+        }
+
+        constexpr OpcodeTable LegacyTable = makeLegacyMap();
+        constexpr OpcodeTable Table0F = makeMap0F();
+        constexpr OpcodeTable Table0F38 = makeExtendedMap(AMD64Decoder::Map0F38);
+        constexpr OpcodeTable Table0F3A = makeExtendedMap(AMD64Decoder::Map0F3A);
+
+        constexpr std::array<OpcodeTable, 11> ExtendedTables = {
+            makeExtendedMap(0), makeExtendedMap(1), makeExtendedMap(2), makeExtendedMap(3),
+            makeExtendedMap(4), makeExtendedMap(5), makeExtendedMap(6), makeExtendedMap(7),
+            makeExtendedMap(8), makeExtendedMap(9), makeExtendedMap(10),
+        };
+
+        inline int32_t loadSigned(const uint8_t *p, int size) {
+            switch (size) {
+                case 1:
+                    return int8_t(*p);
+                case 2:
+                    return loadValue<ByteOrder::LittleEndian, int16_t>(p);
+                default:
+                    break;
+            }
+            return loadValue<ByteOrder::LittleEndian, int32_t>(p);
+        }
+
+        inline bool legacyPrefix(uint8_t byte, uint16_t &flags) {
+            switch (byte) {
+                case 0xF0:
+                    flags |= AMD64Decoder::Lock;
+                    return true;
+                case 0xF2:
+                    flags |= AMD64Decoder::RepNE;
+                    return true;
+                case 0xF3:
+                    flags |= AMD64Decoder::Rep;
+                    return true;
+                case 0x66:
+                    flags |= AMD64Decoder::OperandSize;
+                    return true;
+                case 0x67:
+                    flags |= AMD64Decoder::AddressSize;
+                    return true;
+                case 0x26:
+                case 0x2E:
+                case 0x36:
+                case 0x3E:
+                case 0x64:
+                case 0x65:
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        inline void setInvalid(Instruction &insn, uint64_t address) {
+            insn.address = address;
+            insn.target = 0;
+            insn.opcode = 0;
+            insn.length = 1;
+            insn.flow = Instruction::Invalid;
+            insn.flags = 0;
+        }
+
+        inline bool decodeInstruction(const uint8_t *data, size_t size, uint64_t address,
+                                      Instruction &insn) {
+            const uint8_t *p = data;
+            const uint8_t *end = data + std::min<size_t>(size, AMD64Decoder::MaxLength);
+
+            // Legacy prefixes and REX, which only counts right before the opcode
+            uint16_t flags = 0;
+            uint8_t rex = 0;
+            for (;; ++p) {
+                if (p == end) {
+                    setInvalid(insn, address);
+                    return false;
+                }
+                if ((*p & 0xF0) == 0x40) {
+                    rex = *p;
+                    continue;
+                }
+                if (!legacyPrefix(*p, flags)) {
+                    break;
+                }
+                rex = 0;
+            }
+
+            if (rex & 0x8) {
+                flags |= AMD64Decoder::RexW;
+            }
+
+            // Opcode, through the escapes and the VEX, EVEX and XOP prefixes
+            int map = AMD64Decoder::LegacyMap;
+            const OpcodeTable *table = &LegacyTable;
+            uint8_t op = *p++;
+            if (op == 0x0F) {
+                if (end - p < 1) {
+                    setInvalid(insn, address);
+                    return false;
+                }
+                op = *p++;
+                map = AMD64Decoder::Map0F;
+                table = &Table0F;
+                if (op == 0x38 || op == 0x3A) {
+                    if (end - p < 1) {
+                        setInvalid(insn, address);
+                        return false;
+                    }
+                    map = op == 0x38 ? AMD64Decoder::Map0F38 : AMD64Decoder::Map0F3A;
+                    table = op == 0x38 ? &Table0F38 : &Table0F3A;
+                    op = *p++;
+                }
+            } else if (op == 0xC4 || op == 0xC5 || op == 0x62 ||
+                       (op == 0x8F && p < end && (*p & 0x38) != 0)) {
+                static constexpr const uint16_t Conflicting = AMD64Decoder::Lock |
+                                                              AMD64Decoder::Rep |
+                                                              AMD64Decoder::RepNE |
+                                                              AMD64Decoder::OperandSize;
+                int payload = op == 0xC5 ? 1 : (op == 0x62 ? 3 : 2);
+                if ((flags & Conflicting) || rex || end - p < payload + 1) {
+                    setInvalid(insn, address);
+                    return false;
+                }
+                if (op == 0xC5) {
+                    map = AMD64Decoder::Map0F;
+                    flags |= AMD64Decoder::Vex;
+                } else if (op == 0x62) {
+                    map = p[0] & 0x7;
+                    flags |= AMD64Decoder::Evex | ((p[1] & 0x80) ? AMD64Decoder::RexW : 0);
+                } else {
+                    map = p[0] & 0x1F;
+                    flags |= AMD64Decoder::Vex | ((p[1] & 0x80) ? AMD64Decoder::RexW : 0);
+                    if ((op == 0x8F) != (map >= AMD64Decoder::XopMap8)) {
+                        map = 0;
+                    }
+                }
+                if (map >= int(ExtendedTables.size())) {
+                    setInvalid(insn, address);
+                    return false;
+                }
+                table = &ExtendedTables[map];
+                p += payload;
+                op = *p++;
+            }
+
+            const auto &info = (*table)[op];
+            if (info.invalid) {
+                setInvalid(insn, address);
+                return false;
+            }
+
+            // ModRM, SIB and displacement
+            uint32_t opcode = op | (map << 8);
+            int reg = 0;
+            int dispSize = 0;
+            bool ripRelative = false;
+            if (info.modrm) {
+                if (end - p < 1) {
+                    setInvalid(insn, address);
+                    return false;
+                }
+                uint8_t modrm = *p++;
+                int mod = modrm >> 6;
+                int rm = modrm & 0x7;
+                reg = (modrm >> 3) & 0x7;
+                opcode |= 0x8000 | (reg << 12);
+
+                // Moves to and from control and debug registers ignore mod
+                bool registerOnly = map == AMD64Decoder::Map0F && op >= 0x20 && op <= 0x23;
+                if (mod != 3 && !registerOnly) {
+                    if (rm == 4) {
+                        if (end - p < 1) {
+                            setInvalid(insn, address);
+                            return false;
+                        }
+                        if (mod == 0 && (*p & 0x7) == 5) {
+                            dispSize = 4;
+                        }
+                        p++;
+                    } else if (mod == 0 && rm == 5) {
+                        dispSize = 4;
+                        ripRelative = true;
+                    }
+                    if (mod == 1) {
+                        dispSize = 1;
+                    } else if (mod == 2) {
+                        dispSize = 4;
+                    }
+                }
+            }
+
+            // Immediate or relative operand
+            int immSize = 0;
+            switch (info.operand) {
+                case NoOperand:
+                    break;
+                case Ib:
+                case Jb:
+                    immSize = 1;
+                    break;
+                case Iw:
+                    immSize = 2;
+                    break;
+                case Iz:
+                    immSize = (flags & AMD64Decoder::OperandSize) ? 2 : 4;
+                    break;
+                case Iv:
+                    immSize = (flags & AMD64Decoder::RexW)
+                                  ? 8
+                                  : ((flags & AMD64Decoder::OperandSize) ? 2 : 4);
+                    break;
+                case Id:
+                case Jz:
+                    immSize = 4;
+                    break;
+                case IwIb:
+                    immSize = 3;
+                    break;
+                case Moffs:
+                    immSize = (flags & AMD64Decoder::AddressSize) ? 4 : 8;
+                    break;
+                case Group3:
+                    if (reg <= 1) {
+                        immSize =
+                            op == 0xF6 ? 1 : ((flags & AMD64Decoder::OperandSize) ? 2 : 4);
+                    }
+                    break;
+            }
+            if (end - p < dispSize + immSize) {
+                setInvalid(insn, address);
+                return false;
+            }
+
+            auto length = int(p - data) + dispSize + immSize;
+            auto next = address + length;
+            insn.address = address;
+            insn.target = 0;
+            insn.opcode = opcode;
+            insn.length = uint8_t(length);
+            insn.flow = info.flow;
+            insn.flags = flags;
+
+            if (info.operand == Jb || info.operand == Jz) {
+                insn.target = next + int64_t(loadSigned(p + dispSize, immSize));
+                insn.flags |= Instruction::DirectTarget;
+            } else if (ripRelative) {
+                insn.target = next + int64_t(loadSigned(p, 4));
+                insn.flags |= Instruction::PCRelative;
+            }
+
+            // Group 5 holds the indirect branches
+            if (map == AMD64Decoder::LegacyMap && op == 0xFF) {
+                switch (reg) {
+                    case 2:
+                    case 3:
+                        insn.flow = Instruction::IndirectCall;
+                        break;
+                    case 4:
+                    case 5:
+                        insn.flow = Instruction::IndirectJump;
+                        break;
+                    case 7:
+                        setInvalid(insn, address);
+                        return false;
+                    default:
+                        break;
+                }
+            }
+            return true;
+        }
+
+    }
+
+    AMD64Decoder::AMD64Decoder() : InstructionDecoder(ElfFile::AMD64) {
+    }
+
+    AMD64Decoder::~AMD64Decoder() = default;
+
+    bool AMD64Decoder::decodeOne(const char *data, size_t size, uint64_t address,
+                                 Instruction &insn) const {
+        return decodeInstruction(reinterpret_cast<const uint8_t *>(data), size, address, insn);
+    }
+
+    size_t AMD64Decoder::decode(const char *data, size_t size, uint64_t address,
+                                InstructionArena &arena) const {
+        auto bytes = reinterpret_cast<const uint8_t *>(data);
+        size_t count = 0;
+        size_t pos = 0;
+        while (pos < size) {
+            auto &insn = arena.append();
+            decodeInstruction(bytes + pos, size - pos, address + pos, insn);
+            pos += insn.length;
+            count++;
+        }
+        return count;
+    }
+
+}
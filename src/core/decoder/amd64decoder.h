@@ -0,0 +1,72 @@
+#ifndef AMD64DECODER_H
+#define AMD64DECODER_H
+
+#include <mtccore/instructiondecoder.h>
+
+namespace MTC {
+
+    // Length and control flow decoder of 64-bit mode x86 code, driven by per-map opcode tables.
+    //
+    // Opcode layout: bits 0-7 hold the opcode byte, bits 8-11 the OpcodeMap, bit 15 is set when
+    // the instruction has a ModRM byte and bits 12-14 then hold its reg field.
+    class MTC_CORE_EXPORT AMD64Decoder : public InstructionDecoder {
+    public:
+        AMD64Decoder();
+        ~AMD64Decoder();
+
+        enum OpcodeMap {
+            LegacyMap = 0,
+            Map0F = 1,
+            Map0F38 = 2,
+            Map0F3A = 3,
+            EvexMap5 = 5,
+            EvexMap6 = 6,
+            XopMap8 = 8,
+            XopMap9 = 9,
+            XopMapA = 10,
+        };
+
+        enum Flag : uint16_t {
+            Lock = Instruction::ArchitectureFlag,
+            Rep = Lock << 1,
+            RepNE = Lock << 2,
+            OperandSize = Lock << 3,
+            AddressSize = Lock << 4,
+            RexW = Lock << 5,
+            Vex = Lock << 6,
+            Evex = Lock << 7,
+        };
+
+        static constexpr const int MaxLength = 15;
+
+    public:
+        bool decodeOne(const char *data, size_t size, uint64_t address,
+                       Instruction &insn) const override;
+        size_t decode(const char *data, size_t size, uint64_t address,
+                      InstructionArena &arena) const override;
+
+        static inline uint8_t opcodeByte(uint32_t opcode);
+        static inline OpcodeMap opcodeMap(uint32_t opcode);
+        static inline bool hasModRM(uint32_t opcode);
+        static inline int modRMReg(uint32_t opcode);
+    };
+
+    inline uint8_t AMD64Decoder::opcodeByte(uint32_t opcode) {
+        return uint8_t(opcode);
+    }
+
+    inline AMD64Decoder::OpcodeMap AMD64Decoder::opcodeMap(uint32_t opcode) {
+        return OpcodeMap((opcode >> 8) & 0xF);
+    }
+
+    inline bool AMD64Decoder::hasModRM(uint32_t opcode) {
+        return opcode & 0x8000;
+    }
+
+    inline int AMD64Decoder::modRMReg(uint32_t opcode) {
+        return (opcode >> 12) & 0x7;
+    }
+
+}
+
+#endif // AMD64DECODER_H
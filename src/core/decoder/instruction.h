@@ -0,0 +1,131 @@
+#ifndef INSTRUCTION_H
+#define INSTRUCTION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <mtccore/mtccoreglobal.h>
+
+namespace MTC {
+
+    // Fixed-size record of one decoded machine instruction. The opcode layout and the flags from
+    // ArchitectureFlag upwards are defined by the decoder of each architecture.
+    class Instruction {
+    public:
+        enum Flow : uint8_t {
+            Sequential,
+            Jump,
+            ConditionalJump,
+            Call,
+            IndirectJump,
+            IndirectCall,
+            Return,
+            Trap,
+            Invalid,
+        };
+
+        enum Flag : uint16_t {
+            // target is the destination of a direct branch
+            DirectTarget = 0x1,
+            // target is a data address computed from the instruction address
+            PCRelative = 0x2,
+            ArchitectureFlag = 0x100,
+        };
+
+        uint64_t address;
+        uint64_t target;
+        uint32_t opcode;
+        uint8_t length;
+        Flow flow;
+        uint16_t flags;
+
+        inline uint64_t end() const;
+        inline bool isBranch() const;
+        inline bool endsBlock() const;
+    };
+
+    inline uint64_t Instruction::end() const {
+        return address + length;
+    }
+
+    inline bool Instruction::isBranch() const {
+        return flow != Sequential && flow != Trap && flow != Invalid;
+    }
+
+    inline bool Instruction::endsBlock() const {
+        return flow != Sequential && flow != Call && flow != IndirectCall;
+    }
+
+    // Reusable storage of decoded instructions, clear() keeps the capacity so that decoding many
+    // ranges in turn does not allocate after the first ones
+    class InstructionArena {
+    public:
+        inline bool isEmpty() const;
+        inline size_t count() const;
+        inline const Instruction *data() const;
+        inline const Instruction &at(size_t index) const;
+        inline const Instruction *begin() const;
+        inline const Instruction *end() const;
+
+        inline void clear();
+        inline void reserve(size_t count);
+        inline Instruction &append();
+        inline void append(const InstructionArena &other);
+
+        // Orders the records by address
+        inline void sortByAddress();
+
+    protected:
+        std::vector<Instruction> _records;
+    };
+
+    inline bool InstructionArena::isEmpty() const {
+        return _records.empty();
+    }
+
+    inline size_t InstructionArena::count() const {
+        return _records.size();
+    }
+
+    inline const Instruction *InstructionArena::data() const {
+        return _records.data();
+    }
+
+    inline const Instruction &InstructionArena::at(size_t index) const {
+        return _records[index];
+    }
+
+    inline const Instruction *InstructionArena::begin() const {
+        return _records.data();
+    }
+
+    inline const Instruction *InstructionArena::end() const {
+        return _records.data() + _records.size();
+    }
+
+    inline void InstructionArena::clear() {
+        _records.clear();
+    }
+
+    inline void InstructionArena::reserve(size_t count) {
+        _records.reserve(count);
+    }
+
+    inline Instruction &InstructionArena::append() {
+        return _records.emplace_back();
+    }
+
+    inline void InstructionArena::append(const InstructionArena &other) {
+        _records.insert(_records.end(), other._records.begin(), other._records.end());
+    }
+
+    inline void InstructionArena::sortByAddress() {
+        std::sort(_records.begin(), _records.end(), [](const Instruction &a, const Instruction &b) {
+            return a.address < b.address;
+        });
+    }
+
+}
+
+#endif // INSTRUCTION_H
@@ -0,0 +1,41 @@
+#include "instructiondecoder.h"
+
+#include "aarch64decoder.h"
+#include "amd64decoder.h"
+#include "riscvdecoder.h"
+
+namespace MTC {
+
+    InstructionDecoder::InstructionDecoder(ElfFile::Architecture arch) : _arch(arch) {
+    }
+
+    InstructionDecoder::~InstructionDecoder() = default;
+
+    size_t InstructionDecoder::decode(const char *data, size_t size, uint64_t address,
+                                      InstructionArena &arena) const {
+        size_t count = 0;
+        size_t pos = 0;
+        while (pos < size) {
+            auto &insn = arena.append();
+            decodeOne(data + pos, size - pos, address + pos, insn);
+            pos += insn.length;
+            count++;
+        }
+        return count;
+    }
+
+    std::unique_ptr<InstructionDecoder> InstructionDecoder::create(ElfFile::Architecture arch) {
+        switch (arch) {
+            case ElfFile::AMD64:
+                return std::make_unique<AMD64Decoder>();
+            case ElfFile::AArch64:
+                return std::make_unique<AArch64Decoder>();
+            case ElfFile::RiscV64:
+                return std::make_unique<RiscVDecoder>();
+            default:
+                break;
+        }
+        return nullptr;
+    }
+
+}
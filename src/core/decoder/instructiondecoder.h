@@ -0,0 +1,42 @@
+#ifndef INSTRUCTIONDECODER_H
+#define INSTRUCTIONDECODER_H
+
+#include <memory>
+
+#include <mtccore/instruction.h>
+#include <mtccore/elffile.h>
+
+namespace MTC {
+
+    class MTC_CORE_EXPORT InstructionDecoder {
+    public:
+        virtual ~InstructionDecoder();
+
+    public:
+        inline ElfFile::Architecture architecture() const;
+
+        // Decodes the instruction at data. Bytes that are not a valid or complete instruction
+        // give an Invalid record whose length is the distance to the next candidate.
+        virtual bool decodeOne(const char *data, size_t size, uint64_t address,
+                               Instruction &insn) const = 0;
+
+        // Linear sweep over a range, appends one record per instruction and returns their count
+        virtual size_t decode(const char *data, size_t size, uint64_t address,
+                              InstructionArena &arena) const;
+
+        // Returns null for architectures without a decoder
+        static std::unique_ptr<InstructionDecoder> create(ElfFile::Architecture arch);
+
+    protected:
+        explicit InstructionDecoder(ElfFile::Architecture arch);
+
+        ElfFile::Architecture _arch;
+    };
+
+    inline ElfFile::Architecture InstructionDecoder::architecture() const {
+        return _arch;
+    }
+
+}
+
+#endif // INSTRUCTIONDECODER_H
@@ -0,0 +1,453 @@
+#include "riscvdecoder.h"
+
+#include <array>
+
+#include "byteorder.h"
+
+namespace MTC {
+
+    namespace {
+
+        inline uint32_t bits(uint32_t value, int high, int low) {
+            return (value >> low) & ((1u << (high - low + 1)) - 1);
+        }
+
+        inline int64_t signExtend(uint32_t value, int bits) {
+            return int64_t(uint64_t(value) << (64 - bits)) >> (64 - bits);
+        }
+
+        enum BaseOpcode : uint32_t {
+            Load = 0x03,
+            LoadFP = 0x07,
+            MiscMem = 0x0F,
+            OpImm = 0x13,
+            Auipc = 0x17,
+            OpImm32 = 0x1B,
+            Store = 0x23,
+            StoreFP = 0x27,
+            Amo = 0x2F,
+            Op = 0x33,
+            Lui = 0x37,
+            Op32 = 0x3B,
+            Branch = 0x63,
+            Jalr = 0x67,
+            Jal = 0x6F,
+            System = 0x73,
+        };
+
+        // Register numbers in the 3-bit fields of compressed instructions
+        constexpr uint32_t compactRegister(uint32_t field) {
+            return field + 8;
+        }
+
+        inline uint32_t encodeR(uint32_t op, uint32_t rd, uint32_t funct3, uint32_t rs1,
+                                uint32_t rs2, uint32_t funct7) {
+            return (funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | op;
+        }
+
+        inline uint32_t encodeI(uint32_t op, uint32_t rd, uint32_t funct3, uint32_t rs1,
+                                int64_t imm) {
+            return (uint32_t(imm & 0xFFF) << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | op;
+        }
+
+        inline uint32_t encodeS(uint32_t op, uint32_t funct3, uint32_t rs1, uint32_t rs2,
+                                int64_t imm) {
+            return (bits(uint32_t(imm), 11, 5) << 25) | (rs2 << 20) | (rs1 << 15) |
+                   (funct3 << 12) | (bits(uint32_t(imm), 4, 0) << 7) | op;
+        }
+
+        inline uint32_t encodeB(uint32_t funct3, uint32_t rs1, uint32_t rs2, int64_t imm) {
+            auto u = uint32_t(imm);
+            return (bits(u, 12, 12) << 31) | (bits(u, 10, 5) << 25) | (rs2 << 20) | (rs1 << 15) |
+                   (funct3 << 12) | (bits(u, 4, 1) << 8) | (bits(u, 11, 11) << 7) | Branch;
+        }
+
+        inline uint32_t encodeU(uint32_t op, uint32_t rd, int64_t imm) {
+            return (uint32_t(imm) & 0xFFFFF000) | (rd << 7) | op;
+        }
+
+        inline uint32_t encodeJ(uint32_t rd, int64_t imm) {
+            auto u = uint32_t(imm);
+            return (bits(u, 20, 20) << 31) | (bits(u, 10, 1) << 21) | (bits(u, 11, 11) << 20) |
+                   (bits(u, 19, 12) << 12) | (rd << 7) | Jal;
+        }
+
+        // Offsets of the doubleword and word forms, scaled by the access size
+        inline uint32_t offsetD(uint32_t c) {
+            return (bits(c, 12, 10) << 3) | (bits(c, 6, 5) << 6);
+        }
+
+        inline uint32_t offsetW(uint32_t c) {
+            return (bits(c, 12, 10) << 3) | (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 6);
+        }
+
+        // RV64C rules, a compressed encoding that is reserved or not part of RV64GC gives 0
+        uint32_t expandCompressed(uint32_t c) {
+            uint32_t funct3 = bits(c, 15, 13);
+            uint32_t rd = bits(c, 11, 7);
+            uint32_t rs2 = bits(c, 6, 2);
+            uint32_t rdp = compactRegister(bits(c, 4, 2));
+            uint32_t rs1p = compactRegister(bits(c, 9, 7));
+            int64_t imm6 = signExtend((bits(c, 12, 12) << 5) | bits(c, 6, 2), 6);
+
+            switch (bits(c, 1, 0)) {
+                case 0:
+                    switch (funct3) {
+                        case 0: {
+                            // C.ADDI4SPN
+                            uint32_t imm = (bits(c, 12, 11) << 4) | (bits(c, 10, 7) << 6) |
+                                           (bits(c, 6, 6) << 2) | (bits(c, 5, 5) << 3);
+                            return imm ? encodeI(OpImm, rdp, 0, 2, imm) : 0;
+                        }
+                        case 1:
+                            return encodeI(LoadFP, rdp, 3, rs1p, offsetD(c));
+                        case 2:
+                            return encodeI(Load, rdp, 2, rs1p, offsetW(c));
+                        case 3:
+                            return encodeI(Load, rdp, 3, rs1p, offsetD(c));
+                        case 5:
+                            return encodeS(StoreFP, 3, rs1p, rdp, offsetD(c));
+                        case 6:
+                            return encodeS(Store, 2, rs1p, rdp, offsetW(c));
+                        case 7:
+                            return encodeS(Store, 3, rs1p, rdp, offsetD(c));
+                        default:
+                            break;
+                    }
+                    break;
+
+                case 1:
+                    switch (funct3) {
+                        case 0:
+                            // C.ADDI and C.NOP
+                            return encodeI(OpImm, rd, 0, rd, imm6);
+                        case 1:
+                            // C.ADDIW
+                            return rd ? encodeI(OpImm32, rd, 0, rd, imm6) : 0;
+                        case 2:
+                            // C.LI
+                            return encodeI(OpImm, rd, 0, 0, imm6);
+                        case 3: {
+                            if (rd == 2) {
+                                // C.ADDI16SP
+                                auto imm = signExtend(
+                                    (bits(c, 12, 12) << 9) | (bits(c, 6, 6) << 4) |
+                                        (bits(c, 5, 5) << 6) | (bits(c, 4, 3) << 7) |
+                                        (bits(c, 2, 2) << 5),
+                                    10);
+                                return imm ? encodeI(OpImm, 2, 0, 2, imm) : 0;
+                            }
+                            // C.LUI
+                            return imm6 ? encodeU(Lui, rd, imm6 * 0x1000) : 0;
+                        }
+                        case 4: {
+                            uint32_t rdc = rs1p;
+                            uint32_t shamt = (bits(c, 12, 12) << 5) | bits(c, 6, 2);
+                            switch (bits(c, 11, 10)) {
+                                case 0:
+                                    return encodeI(OpImm, rdc, 5, rdc, shamt);
+                                case 1:
+                                    return encodeI(OpImm, rdc, 5, rdc, shamt | 0x400);
+                                case 2:
+                                    return encodeI(OpImm, rdc, 7, rdc, imm6);
+                                default:
+                                    break;
+                            }
+                            static constexpr const uint32_t Funct3[] = {0, 4, 6, 7};
+                            uint32_t op = bits(c, 6, 5);
+                            if (!bits(c, 12, 12)) {
+                                return encodeR(Op, rdc, Funct3[op], rdc, rdp, op == 0 ? 0x20 : 0);
+                            }
+                            // C.SUBW and C.ADDW
+                            if (op < 2) {
+                                return encodeR(Op32, rdc, 0, rdc, rdp, op == 0 ? 0x20 : 0);
+                            }
+                            break;
+                        }
+                        case 5: {
+                            // C.J
+                            auto imm = signExtend(
+                                (bits(c, 12, 12) << 11) | (bits(c, 11, 11) << 4) |
+                                    (bits(c, 10, 9) << 8) | (bits(c, 8, 8) << 10) |
+                                    (bits(c, 7, 7) << 6) | (bits(c, 6, 6) << 7) |
+                                    (bits(c, 5, 3) << 1) | (bits(c, 2, 2) << 5),
+                                12);
+                            return encodeJ(0, imm);
+                        }
+                        default: {
+                            // C.BEQZ and C.BNEZ
+                            auto imm = signExtend(
+                                (bits(c, 12, 12) << 8) | (bits(c, 11, 10) << 3) |
+                                    (bits(c, 6, 5) << 6) | (bits(c, 4, 3) << 1) |
+                                    (bits(c, 2, 2) << 5),
+                                9);
+                            return encodeB(funct3 - 6, rs1p, 0, imm);
+                        }
+                    }
+                    break;
+
+                case 2: {
+                    uint32_t offsetDSP = (bits(c, 12, 12) << 5) | (bits(c, 6, 5) << 3) |
+                                         (bits(c, 4, 2) << 6);
+                    uint32_t offsetWSP = (bits(c, 12, 12) << 5) | (bits(c, 6, 4) << 2) |
+                                         (bits(c, 3, 2) << 6);
+                    uint32_t storeDSP = (bits(c, 12, 10) << 3) | (bits(c, 9, 7) << 6);
+                    uint32_t storeWSP = (bits(c, 12, 9) << 2) | (bits(c, 8, 7) << 6);
+                    switch (funct3) {
+                        case 0:
+                            // C.SLLI
+                            return encodeI(OpImm, rd, 1, rd,
+                                           (bits(c, 12, 12) << 5) | bits(c, 6, 2));
+                        case 1:
+                            return encodeI(LoadFP, rd, 3, 2, offsetDSP);
+                        case 2:
+                            return rd ? encodeI(Load, rd, 2, 2, offsetWSP) : 0;
+                        case 3:
+                            return rd ? encodeI(Load, rd, 3, 2, offsetDSP) : 0;
+                        case 4:
+                            if (!bits(c, 12, 12)) {
+                                if (rs2) {
+                                    // C.MV
+                                    return encodeR(Op, rd, 0, 0, rs2, 0);
+                                }
+                                // C.JR
+                                return rd ? encodeI(Jalr, 0, 0, rd, 0) : 0;
+                            }
+                            if (rs2) {
+                                // C.ADD
+                                return encodeR(Op, rd, 0, rd, rs2, 0);
+                            }
+                            // C.EBREAK and C.JALR
+                            return rd ? encodeI(Jalr, 1, 0, rd, 0) : 0x00100073;
+                        case 5:
+                            return encodeS(StoreFP, 3, 2, rs2, storeDSP);
+                        case 6:
+                            return encodeS(Store, 2, 2, rs2, storeWSP);
+                        default:
+                            return encodeS(Store, 3, 2, rs2, storeDSP);
+                    }
+                }
+
+                default:
+                    break;
+            }
+            return 0;
+        }
+
+        using Expansion = std::array<uint32_t, 0x10000>;
+
+        const Expansion &expansionTable() {
+            static const Expansion table = [] {
+                Expansion result{};
+                for (uint32_t i = 0; i < result.size(); ++i) {
+                    result[i] = expandCompressed(i);
+                }
+                return result;
+            }();
+            return table;
+        }
+
+        enum Kind : uint8_t {
+            Illegal,
+            Plain,
+            MemoryAccess,
+            ConditionalBranch,
+            JumpAndLink,
+            JumpAndLinkRegister,
+            AddUpperPC,
+            SystemCall,
+        };
+
+        // Indexed by bits 6:2 of a 32-bit instruction
+        constexpr std::array<Kind, 32> makeKindTable() {
+            std::array<Kind, 32> t{};
+            // The fused multiply-add and OP-FP opcodes are 0x43 to 0x53
+            for (uint32_t op : {uint32_t(MiscMem), uint32_t(OpImm), uint32_t(OpImm32),
+                                uint32_t(Op), uint32_t(Lui), uint32_t(Op32), 0x43u, 0x47u, 0x4Bu,
+                                0x4Fu, 0x53u}) {
+                t[op >> 2] = Plain;
+            }
+            for (auto op : {Load, LoadFP, Store, StoreFP, Amo}) {
+                t[op >> 2] = MemoryAccess;
+            }
+            t[Branch >> 2] = ConditionalBranch;
+            t[Jal >> 2] = JumpAndLink;
+            t[Jalr >> 2] = JumpAndLinkRegister;
+            t[Auipc >> 2] = AddUpperPC;
+            t[System >> 2] = SystemCall;
+            return t;
+        }
+
+        constexpr std::array<Kind, 32> KindTable = makeKindTable();
+
+        // x1 and x5 are the link registers of the standard calling convention
+        inline bool isLink(uint32_t reg) {
+            return reg == 1 || reg == 5;
+        }
+
+        inline void setInvalid(Instruction &insn, uint64_t address, size_t length) {
+            insn.address = address;
+            insn.target = 0;
+            insn.opcode = 0;
+            insn.length = uint8_t(length);
+            insn.flow = Instruction::Invalid;
+            insn.flags = 0;
+        }
+
+        inline bool decodeWord(uint32_t word, int length, uint64_t address, Instruction &insn) {
+            insn.address = address;
+            insn.target = 0;
+            insn.opcode = word;
+            insn.length = uint8_t(length);
+            insn.flow = Instruction::Sequential;
+            insn.flags = length == RiscVDecoder::ParcelSize ? RiscVDecoder::Compressed : 0;
+
+            uint32_t rd = bits(word, 11, 7);
+            uint32_t funct3 = bits(word, 14, 12);
+            switch (KindTable[bits(word, 6, 2)]) {
+                case Illegal:
+                    insn.flow = Instruction::Invalid;
+                    break;
+                case Plain:
+                    break;
+                case MemoryAccess:
+                    insn.flags |= RiscVDecoder::Memory;
+                    break;
+                case ConditionalBranch: {
+                    if (funct3 == 2 || funct3 == 3) {
+                        insn.flow = Instruction::Invalid;
+                        break;
+                    }
+                    auto imm = signExtend((bits(word, 31, 31) << 12) | (bits(word, 7, 7) << 11) |
+                                              (bits(word, 30, 25) << 5) | (bits(word, 11, 8) << 1),
+                                          13);
+                    insn.flow = Instruction::ConditionalJump;
+                    insn.target = address + imm;
+                    insn.flags |= Instruction::DirectTarget;
+                    break;
+                }
+                case JumpAndLink: {
+                    auto imm = signExtend((bits(word, 31, 31) << 20) | (bits(word, 19, 12) << 12) |
+                                              (bits(word, 20, 20) << 11) |
+                                              (bits(word, 30, 21) << 1),
+                                          21);
+                    insn.flow = rd ? Instruction::Call : Instruction::Jump;
+                    insn.target = address + imm;
+                    insn.flags |= Instruction::DirectTarget;
+                    break;
+                }
+                case JumpAndLinkRegister: {
+                    if (funct3 != 0) {
+                        insn.flow = Instruction::Invalid;
+                    } else if (rd) {
+                        insn.flow = Instruction::IndirectCall;
+                    } else if (isLink(bits(word, 19, 15))) {
+                        insn.flow = Instruction::Return;
+                    } else {
+                        insn.flow = Instruction::IndirectJump;
+                    }
+                    break;
+                }
+                case AddUpperPC:
+                    insn.target = address + signExtend(word & 0xFFFFF000, 32);
+                    insn.flags |= Instruction::PCRelative;
+                    break;
+                case SystemCall:
+                    switch (word) {
+                        case 0x00100073:
+                            // EBREAK
+                            insn.flow = Instruction::Trap;
+                            break;
+                        case 0x10200073:
+                        case 0x30200073:
+                            // SRET and MRET
+                            insn.flow = Instruction::Return;
+                            break;
+                        case 0xC0001073:
+                            // UNIMP
+                            insn.flow = Instruction::Trap;
+                            break;
+                        default:
+                            insn.flags |= RiscVDecoder::SystemControl;
+                            break;
+                    }
+                    break;
+            }
+            return insn.flow != Instruction::Invalid;
+        }
+
+        inline bool decodeInstruction(const uint8_t *data, size_t size, uint64_t address,
+                                      const uint32_t *expansion, Instruction &insn) {
+            if (size < RiscVDecoder::ParcelSize) {
+                setInvalid(insn, address, size);
+                return false;
+            }
+
+            auto parcel = loadValue<ByteOrder::LittleEndian, uint16_t>(data);
+            if ((parcel & 0x3) != 0x3) {
+                auto word = expansion[parcel];
+                if (!word) {
+                    // The all-zero parcel is defined to be illegal, it stops execution like UNIMP
+                    setInvalid(insn, address, RiscVDecoder::ParcelSize);
+                    if (!parcel) {
+                        insn.flow = Instruction::Trap;
+                        insn.flags = RiscVDecoder::Compressed;
+                    }
+                    return false;
+                }
+                return decodeWord(word, RiscVDecoder::ParcelSize, address, insn);
+            }
+
+            // Encodings longer than 32 bits are not part of RV64GC
+            if ((parcel & 0x1C) == 0x1C || size < 4) {
+                setInvalid(insn, address, RiscVDecoder::ParcelSize);
+                return false;
+            }
+            return decodeWord(loadValue<ByteOrder::LittleEndian, uint32_t>(data), 4, address,
+                              insn);
+        }
+
+    }
+
+    RiscVDecoder::RiscVDecoder()
+        : InstructionDecoder(ElfFile::RiscV64), _expansion(expansionTable().data()) {
+    }
+
+    RiscVDecoder::~RiscVDecoder() = default;
+
+    bool RiscVDecoder::decodeOne(const char *data, size_t size, uint64_t address,
+                                 Instruction &insn) const {
+        if (address % ParcelSize) {
+            setInvalid(insn, address, 1);
+            return false;
+        }
+        return decodeInstruction(reinterpret_cast<const uint8_t *>(data), size, address,
+                                 _expansion, insn);
+    }
+
+    size_t RiscVDecoder::decode(const char *data, size_t size, uint64_t address,
+                                InstructionArena &arena) const {
+        auto bytes = reinterpret_cast<const uint8_t *>(data);
+        size_t count = 0;
+        size_t pos = 0;
+
+        // Skip to the first parcel boundary
+        if (size > 0 && address % ParcelSize) {
+            setInvalid(arena.append(), address, 1);
+            pos = 1;
+            count++;
+        }
+        while (pos < size) {
+            auto &insn = arena.append();
+            decodeInstruction(bytes + pos, size - pos, address + pos, _expansion, insn);
+            pos += insn.length;
+            count++;
+        }
+        return count;
+    }
+
+    uint32_t RiscVDecoder::expand(uint16_t parcel) {
+        return expansionTable()[parcel];
+    }
+
+}
@@ -0,0 +1,44 @@
+#ifndef RISCVDECODER_H
+#define RISCVDECODER_H
+
+#include <mtccore/instructiondecoder.h>
+
+namespace MTC {
+
+    // Decoder of RV64GC code. Compressed instructions are expanded to their 32-bit equivalents
+    // through a table indexed by the whole 16-bit parcel, so both lengths share one decoding
+    // path after a single lookup.
+    //
+    // Opcode layout: the 32-bit instruction word, expanded for compressed instructions.
+    class MTC_CORE_EXPORT RiscVDecoder : public InstructionDecoder {
+    public:
+        RiscVDecoder();
+        ~RiscVDecoder();
+
+        enum Flag : uint16_t {
+            Compressed = Instruction::ArchitectureFlag,
+            Memory = Compressed << 1,
+            SystemControl = Compressed << 2,
+        };
+
+        // Instructions start on parcel boundaries when the C extension is present
+        static constexpr const int ParcelSize = 2;
+
+    public:
+        bool decodeOne(const char *data, size_t size, uint64_t address,
+                       Instruction &insn) const override;
+        size_t decode(const char *data, size_t size, uint64_t address,
+                      InstructionArena &arena) const override;
+
+        // Returns the 32-bit equivalent of a compressed instruction, or 0 if the parcel is not a
+        // valid compressed instruction
+        static uint32_t expand(uint16_t parcel);
+
+    protected:
+        // Shared by all decoders, built on first use
+        const uint32_t *_expansion;
+    };
+
+}
+
+#endif // RISCVDECODER_H
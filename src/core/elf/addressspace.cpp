@@ -0,0 +1,70 @@
+#include "addressspace.h"
+
+#include <algorithm>
+
+#include "elffile_p.h"
+
+namespace MTC {
+
+    AddressSpace::AddressSpace() = default;
+
+    AddressSpace::AddressSpace(const std::shared_ptr<ElfFileSharedContainer> &container)
+        : _container(container) {
+        class Interval {
+        public:
+            uint64_t start;
+            uint64_t end;
+            const char *data;
+            AddressSpan::Kind kind;
+            int attributes;
+        };
+
+        std::vector<Interval> intervals;
+        for (size_t i = 0; i < container->programHeaders.size(); ++i) {
+            const auto &ph = container->programHeaders[i];
+            if (ph.type != ProgramHeader::Loadable) {
+                continue;
+            }
+
+            // A segment whose data cannot be read is left unmapped
+            auto start = uint64_t(ph.virtualAddress);
+            auto fileSize = std::min<uint64_t>(ph.size, ph.memSize);
+            if (fileSize > 0) {
+                auto data = container->programData(i);
+                if (data.size() != ph.size) {
+                    continue;
+                }
+                intervals.push_back(
+                    {start, start + fileSize, data.data(), AddressSpan::FileBacked, ph.attr});
+            }
+            if (ph.memSize > fileSize) {
+                intervals.push_back({start + fileSize, start + ph.memSize, nullptr,
+                                     AddressSpan::ZeroFill, ph.attr});
+            }
+        }
+        std::stable_sort(intervals.begin(), intervals.end(),
+                         [](const Interval &a, const Interval &b) {
+                             return a.start < b.start;
+                         });
+
+        _starts.reserve(intervals.size());
+        _ends.reserve(intervals.size());
+        _data.reserve(intervals.size());
+        _kinds.reserve(intervals.size());
+        _attributes.reserve(intervals.size());
+        for (const auto &interval : intervals) {
+            _starts.push_back(interval.start);
+            _ends.push_back(interval.end);
+            _data.push_back(interval.data);
+            _kinds.push_back(interval.kind);
+            _attributes.push_back(interval.attributes);
+        }
+    }
+
+    AddressSpace::~AddressSpace() = default;
+
+    bool AddressSpace::isValid() const {
+        return _container != nullptr;
+    }
+
+}
@@ -0,0 +1,112 @@
+#ifndef ADDRESSSPACE_H
+#define ADDRESSSPACE_H
+
+#include <algorithm>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <mtccore/mtccoreglobal.h>
+
+namespace MTC {
+
+    class ElfFileSharedContainer;
+
+    class AddressSpan {
+    public:
+        enum Kind {
+            Unmapped,
+            FileBacked,
+            ZeroFill,
+        };
+
+        Kind kind = Unmapped;
+        uint64_t address = 0;
+        uint64_t size = 0;
+
+        // Only set for file backed spans
+        const char *data = nullptr;
+
+        // ProgramHeader::Attribute flags of the segment
+        int attributes = 0;
+    };
+
+    // Sorted interval index over the loadable segments of a file. Each segment contributes its
+    // file backed part and the zero filled tail beyond its file size, and lookups neither
+    // allocate nor copy.
+    class MTC_CORE_EXPORT AddressSpace {
+    public:
+        AddressSpace();
+        ~AddressSpace();
+
+    public:
+        bool isValid() const;
+
+        inline int count() const;
+        inline AddressSpan span(int index) const;
+
+        // Part of [address, address + size) that starts at the address and lies in a single
+        // interval, an unmapped span extends to the next interval
+        inline AddressSpan find(uint64_t address, uint64_t size) const;
+
+        // File bytes of the whole range, empty unless one file backed interval covers it
+        inline std::string_view bytes(uint64_t address, size_t size) const;
+
+    protected:
+        explicit AddressSpace(const std::shared_ptr<ElfFileSharedContainer> &container);
+
+        std::shared_ptr<ElfFileSharedContainer> _container;
+
+        // Intervals as parallel arrays sorted by start address
+        std::vector<uint64_t> _starts;
+        std::vector<uint64_t> _ends;
+        std::vector<const char *> _data;
+        std::vector<AddressSpan::Kind> _kinds;
+        std::vector<int> _attributes;
+
+        friend class ElfFile;
+    };
+
+    inline int AddressSpace::count() const {
+        return int(_starts.size());
+    }
+
+    inline AddressSpan AddressSpace::span(int index) const {
+        AddressSpan res;
+        res.kind = _kinds[index];
+        res.address = _starts[index];
+        res.size = _ends[index] - _starts[index];
+        res.data = _data[index];
+        res.attributes = _attributes[index];
+        return res;
+    }
+
+    inline AddressSpan AddressSpace::find(uint64_t address, uint64_t size) const {
+        auto i = size_t(std::upper_bound(_starts.begin(), _starts.end(), address) -
+                        _starts.begin());
+
+        AddressSpan res;
+        res.address = address;
+        if (i > 0 && address < _ends[i - 1]) {
+            --i;
+            res.kind = _kinds[i];
+            res.size = std::min(size, _ends[i] - address);
+            res.data = _data[i] ? _data[i] + (address - _starts[i]) : nullptr;
+            res.attributes = _attributes[i];
+            return res;
+        }
+        res.size = i < _starts.size() ? std::min(size, _starts[i] - address) : size;
+        return res;
+    }
+
+    inline std::string_view AddressSpace::bytes(uint64_t address, size_t size) const {
+        auto span = find(address, size);
+        if (span.kind != AddressSpan::FileBacked || span.size != size) {
+            return {};
+        }
+        return {span.data, size};
+    }
+
+}
+
+#endif // ADDRESSSPACE_H
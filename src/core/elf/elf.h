@@ -246,6 +246,12 @@ typedef struct mips_elf_abiflags_v0 {
 #define DT_FINI_ARRAYSZ 28
 #define DT_RUNPATH      29
 #define DT_FLAGS        30
+#define DT_PREINIT_ARRAY   32
+#define DT_PREINIT_ARRAYSZ 33
+#define DT_SYMTAB_SHNDX 34
+#define DT_RELRSZ       35
+#define DT_RELR         36
+#define DT_RELRENT      37
 #define DT_LOOS         0x6000000d
 #define DT_HIOS         0x6ffff000
 #define DT_LOPROC       0x70000000
@@ -261,6 +267,10 @@ typedef struct mips_elf_abiflags_v0 {
 #define DT_ADDRRNGLO    0x6ffffe00
 #define DT_ADDRRNGHI    0x6ffffeff
 
+#define DT_GNU_HASH     0x6ffffef5
+#define DT_TLSDESC_PLT  0x6ffffef6
+#define DT_TLSDESC_GOT  0x6ffffef7
+
 #define DT_VERSYM       0x6ffffff0
 #define DT_RELACOUNT    0x6ffffff9
 #define DT_RELCOUNT     0x6ffffffa
@@ -295,11 +305,17 @@ typedef struct mips_elf_abiflags_v0 {
 #define STB_GLOBAL 1
 #define STB_WEAK   2
 
+#define STN_UNDEF  0
+
 #define STT_NOTYPE  0
 #define STT_OBJECT  1
 #define STT_FUNC    2
 #define STT_SECTION 3
 #define STT_FILE    4
+#define STT_COMMON  5
+#define STT_TLS     6
+#define STT_LOOS    10
+#define STT_GNU_IFUNC 10
 
 #define ELF_ST_BIND(x)          ((x) >> 4)
 #define ELF_ST_TYPE(x)          (((unsigned int) x) & 0xf)
@@ -1576,6 +1592,11 @@ typedef struct elf64_phdr {
 #define SHT_SHLIB           10
 #define SHT_DYNSYM          11
 #define SHT_NUM             12
+#define SHT_RELR            19
+#define SHT_ANDROID_REL     0x60000001
+#define SHT_ANDROID_RELA    0x60000002
+#define SHT_ANDROID_RELR    0x6fffff00
+#define SHT_GNU_HASH        0x6ffffff6
 #define SHT_LOPROC          0x70000000
 #define SHT_HIPROC          0x7fffffff
 #define SHT_LOUSER          0x80000000
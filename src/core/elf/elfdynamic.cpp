@@ -0,0 +1,126 @@
+#include "elfdynamic.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "elffile_p.h"
+#include "elftraits_p.h"
+
+namespace MTC {
+
+    // Visits the entries up to the first DT_NULL, only the tag is sign extended
+    template <class Traits, class Visitor>
+    static void readEntries(std::string_view data, Visitor visitor) {
+        using Dyn = typename Traits::Dyn;
+        auto count = data.size() / sizeof(Dyn);
+        for (size_t i = 0; i < count; ++i) {
+            Dyn dyn;
+            memcpy(&dyn, data.data() + i * sizeof(Dyn), sizeof(Dyn));
+            Traits::toHost(dyn);
+            auto tag = int64_t(dyn.d_tag);
+            if (tag == DT_NULL) {
+                break;
+            }
+            visitor(tag, uint64_t(typename Traits::Word(dyn.d_un.d_val)));
+        }
+    }
+
+    ElfDynamic::ElfDynamic() : _values{} {
+    }
+
+    ElfDynamic::ElfDynamic(const ElfFile &file) : ElfDynamic() {
+        const auto &container = file._impl->container;
+        if (!container) {
+            return;
+        }
+
+        std::string_view dynamic;
+        bool found = false;
+        for (size_t i = 0; i < container->programHeaders.size(); ++i) {
+            const auto &ph = container->programHeaders[i];
+            if (ph.type == ProgramHeader::Loadable) {
+                _segments.push_back({ph.virtualAddress, ph.size, ph.offset});
+            } else if (ph.type == ProgramHeader::DynamicLinking && !found) {
+                dynamic = container->programData(i);
+                found = true;
+            }
+        }
+        if (!found) {
+            return;
+        }
+        std::sort(_segments.begin(), _segments.end(), [](const Segment &a, const Segment &b) {
+            return a.address < b.address;
+        });
+        _container = container;
+
+        // Later tags of the same kind are ignored
+        std::vector<uint64_t> needed;
+        auto add = [&](int64_t tag, uint64_t value) {
+            if (tag == DT_NEEDED) {
+                needed.push_back(value);
+            }
+
+            auto index = slot(tag);
+            if (index < 0) {
+                _others.emplace_back(tag, value);
+            } else if (!_present.test(index)) {
+                _values[index] = value;
+                _present.set(index);
+            }
+        };
+        visitElfTraits(container->elfClass, container->byteOrder, [&](auto traits) {
+            readEntries<decltype(traits)>(dynamic, add);
+        });
+
+        _strtab = StringTableView(data(DT_STRTAB, DT_STRSZ));
+        _needed.reserve(needed.size());
+        for (auto offset : needed) {
+            _needed.push_back(_strtab.at(offset));
+        }
+        if (contains(DT_SONAME)) {
+            _soname = _strtab.at(value(DT_SONAME));
+        }
+        if (contains(DT_RUNPATH)) {
+            _runPath = _strtab.at(value(DT_RUNPATH));
+        } else if (contains(DT_RPATH)) {
+            _runPath = _strtab.at(value(DT_RPATH));
+        }
+    }
+
+    ElfDynamic::~ElfDynamic() = default;
+
+    bool ElfDynamic::isValid() const {
+        return _container != nullptr;
+    }
+
+    int64_t ElfDynamic::addressToOffset(uint64_t address) const {
+        auto less = [](uint64_t address, const Segment &segment) {
+            return address < segment.address;
+        };
+        auto it = std::upper_bound(_segments.begin(), _segments.end(), address, less);
+        if (it == _segments.begin()) {
+            return -1;
+        }
+        --it;
+        if (address - it->address >= it->size) {
+            return -1;
+        }
+        return int64_t(it->offset + (address - it->address));
+    }
+
+    int64_t ElfDynamic::fileOffset(int64_t tag) const {
+        if (!contains(tag)) {
+            return -1;
+        }
+        return addressToOffset(value(tag));
+    }
+
+    std::string_view ElfDynamic::data(int64_t addressTag, int64_t sizeTag) const {
+        auto offset = fileOffset(addressTag);
+        if (offset < 0 || !contains(sizeTag)) {
+            return {};
+        }
+        return _container->fileData(uint64_t(offset), size_t(value(sizeTag)));
+    }
+
+}
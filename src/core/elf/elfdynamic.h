@@ -0,0 +1,140 @@
+#ifndef ELFDYNAMIC_H
+#define ELFDYNAMIC_H
+
+#include <bitset>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <mtccore/elf.h>
+#include <mtccore/mtccoreglobal.h>
+#include <mtccore/stringtableview.h>
+
+namespace MTC {
+
+    class ElfFile;
+
+    class ElfFileSharedContainer;
+
+    // Index of the PT_DYNAMIC entries of a file. Every tag is looked up in constant time and
+    // address valued tags are resolved to file offsets through the loadable segments.
+    class MTC_CORE_EXPORT ElfDynamic {
+    public:
+        ElfDynamic();
+        explicit ElfDynamic(const ElfFile &file);
+        ~ElfDynamic();
+
+    public:
+        bool isValid() const;
+
+        // Value of the first entry with the tag
+        inline bool contains(int64_t tag) const;
+        inline uint64_t value(int64_t tag, uint64_t defaultValue = 0) const;
+
+        // File offset of a virtual address or of an address valued tag, or -1 if no loadable
+        // segment maps it from the file
+        int64_t addressToOffset(uint64_t address) const;
+        int64_t fileOffset(int64_t tag) const;
+
+        // File bytes addressed by a tag and sized by another, e.g. DT_JMPREL and DT_PLTRELSZ
+        std::string_view data(int64_t addressTag, int64_t sizeTag) const;
+
+        // DT_STRTAB, sized by DT_STRSZ
+        inline const StringTableView &stringTable() const;
+
+        inline const std::vector<std::string_view> &needed() const;
+        inline std::string_view soname() const;
+        inline std::string_view runPath() const;
+
+    protected:
+        // Tags 0 to DT_RELRENT, then the GNU address range and the version range
+        static constexpr const int StandardTagCount = DT_RELRENT + 1;
+        static constexpr const int GnuTagCount = DT_ADDRRNGHI - DT_GNU_HASH + 1;
+        static constexpr const int VersionTagCount = DT_VERNEEDNUM - DT_VERSYM + 1;
+        static constexpr const int SlotCount = StandardTagCount + GnuTagCount + VersionTagCount;
+
+        static inline int slot(int64_t tag);
+
+        class Segment {
+        public:
+            uint64_t address;
+            uint64_t size;
+            uint64_t offset;
+        };
+
+        std::shared_ptr<ElfFileSharedContainer> _container;
+
+        uint64_t _values[SlotCount];
+        std::bitset<SlotCount> _present;
+
+        // Tags outside of the indexed ranges, in file order
+        std::vector<std::pair<int64_t, uint64_t>> _others;
+
+        // Loadable segments sorted by address
+        std::vector<Segment> _segments;
+
+        StringTableView _strtab;
+        std::vector<std::string_view> _needed;
+        std::string_view _soname;
+        std::string_view _runPath;
+    };
+
+    inline int ElfDynamic::slot(int64_t tag) {
+        if (tag >= 0 && tag < StandardTagCount) {
+            return int(tag);
+        }
+        if (tag >= DT_GNU_HASH && tag <= DT_ADDRRNGHI) {
+            return StandardTagCount + int(tag - DT_GNU_HASH);
+        }
+        if (tag >= DT_VERSYM && tag <= DT_VERNEEDNUM) {
+            return StandardTagCount + GnuTagCount + int(tag - DT_VERSYM);
+        }
+        return -1;
+    }
+
+    inline bool ElfDynamic::contains(int64_t tag) const {
+        auto i = slot(tag);
+        if (i >= 0) {
+            return _present.test(i);
+        }
+        for (const auto &item : _others) {
+            if (item.first == tag) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint64_t ElfDynamic::value(int64_t tag, uint64_t defaultValue) const {
+        auto i = slot(tag);
+        if (i >= 0) {
+            return _present.test(i) ? _values[i] : defaultValue;
+        }
+        for (const auto &item : _others) {
+            if (item.first == tag) {
+                return item.second;
+            }
+        }
+        return defaultValue;
+    }
+
+    inline const StringTableView &ElfDynamic::stringTable() const {
+        return _strtab;
+    }
+
+    inline const std::vector<std::string_view> &ElfDynamic::needed() const {
+        return _needed;
+    }
+
+    inline std::string_view ElfDynamic::soname() const {
+        return _soname;
+    }
+
+    inline std::string_view ElfDynamic::runPath() const {
+        return _runPath;
+    }
+
+}
+
+#endif // ELFDYNAMIC_H
@@ -1,154 +1,457 @@
 #include "elffile.h"
 #include "elffile_p.h"
 
-#include <fstream>
 #include <cstring>
+#include <algorithm>
+#include <iterator>
 #include <sstream>
+#include <thread>
 
 #include "elf.h"
+#include "elftraits_p.h"
 #include "stream.h"
 #include "format.h"
+#include "stringtableview.h"
+#include "threadpool.h"
 
 namespace fs = std::filesystem;
 
 namespace MTC {
 
-    ElfFile::ElfFile() : _impl(std::make_unique<Impl>()) {
+    static constexpr const size_t HeadReadSize = 4096;
+
+    static constexpr const uint64_t PreloadMaxGap = 64 * 1024;
+
+    // Merges the file ranges of all sections and segments into blocks of overlapping ranges, so
+    // that the bytes shared by a segment and the sections inside it are held only once.
+    static void buildDataBlocks(ElfFileSharedContainer &container) {
+        struct Range {
+            uint64_t offset;
+            uint64_t end;
+            size_t *block;
+        };
+
+        std::vector<Range> ranges;
+        ranges.reserve(container.programHeaders.size() + container.sectionHeaders.size());
+        for (auto &ph : container.programHeaders) {
+            if (ph.size > 0) {
+                ranges.push_back({ph.offset, ph.offset + ph.size, &ph.block});
+            }
+        }
+        for (auto &sh : container.sectionHeaders) {
+            if (sh.size > 0) {
+                ranges.push_back({sh.offset, sh.offset + sh.size, &sh.block});
+            }
+        }
+        std::sort(ranges.begin(), ranges.end(), [](const Range &lhs, const Range &rhs) {
+            return lhs.offset < rhs.offset;
+        });
+
+        auto &blocks = container.blocks;
+        for (const auto &range : ranges) {
+            if (blocks.empty() || range.offset >= blocks.back().offset + blocks.back().size) {
+                auto &block = blocks.emplace_back();
+                block.offset = range.offset;
+            }
+            auto &block = blocks.back();
+            block.size = std::max(block.size, size_t(range.end - block.offset));
+            *range.block = blocks.size() - 1;
+        }
+        container.blockOnce = std::make_unique<std::once_flag[]>(blocks.size());
     }
 
-    ElfFile::~ElfFile() {
+    const DataBlock &ElfFileSharedContainer::fetchBlock(size_t index) {
+        auto &block = blocks[index];
+        std::call_once(blockOnce[index], [&]() {
+            if (mapping) {
+                block.data = mapping->data() + block.offset;
+                return;
+            }
+            if (!file) {
+                return;
+            }
+            const RandomAccessFile *source = file.get();
+            RandomAccessFile reopened;
+            if (!source->isOpen()) {
+                if (!reopened.open(path)) {
+                    return;
+                }
+                source = &reopened;
+            }
+            block.buffer.resize(block.size);
+            if (source->read(block.offset, block.buffer.data(), block.size) != block.size) {
+                block.buffer = {};
+                return;
+            }
+            block.data = block.buffer.data();
+        });
+        return block;
     }
 
-    bool ElfFile::load(const fs::path &path) const {
-        std::ifstream file(path, std::ios::binary);
-        if (!file.is_open())
-            return false;
+    std::string_view ElfFileSharedContainer::entryData(size_t block, uint64_t offset, size_t size) {
+        if (size == 0) {
+            return {};
+        }
+        const auto &b = fetchBlock(block);
+        if (!b.data) {
+            return {};
+        }
+        return {b.data + (offset - b.offset), size};
+    }
 
-        ElfFileSharedContainer container;
+    std::string_view ElfFileSharedContainer::fileData(uint64_t offset, size_t size) {
+        auto less = [](uint64_t offset, const DataBlock &block) {
+            return offset < block.offset;
+        };
+        auto it = std::upper_bound(blocks.begin(), blocks.end(), offset, less);
+        if (it == blocks.begin()) {
+            return {};
+        }
+        --it;
+        if (offset - it->offset > it->size || size > it->size - (offset - it->offset)) {
+            return {};
+        }
+        return entryData(size_t(it - blocks.begin()), offset, size);
+    }
 
-        // Read header
-        ::Elf64_Ehdr header;
-        file.read(reinterpret_cast<char *>(&header), sizeof(header));
-        if (!file.good()) {
-            _impl->err = formatTextN("%1: Failed to read ELF header", path);
-            return false;
+    // Reads all blocks with as few requests as possible, neighbouring blocks separated by small
+    // gaps are read in one sequential request and the gap bytes are discarded.
+    static void preloadBlocks(ElfFileSharedContainer &container) {
+        auto &blocks = container.blocks;
+        std::vector<char> gapBuffer;
+        std::vector<RandomAccessFile::Segment> segments;
+        std::vector<bool> fetched(blocks.size());
+
+        size_t first = 0;
+        while (first < blocks.size()) {
+            auto runOffset = blocks[first].offset;
+            auto runEnd = runOffset;
+
+            segments.clear();
+            size_t last = first;
+            for (; last < blocks.size(); ++last) {
+                auto &block = blocks[last];
+                auto gap = block.offset - runEnd;
+                if (gap > PreloadMaxGap) {
+                    break;
+                }
+                if (gap > 0) {
+                    if (gapBuffer.empty()) {
+                        gapBuffer.resize(PreloadMaxGap);
+                    }
+                    segments.push_back({gapBuffer.data(), size_t(gap)});
+                }
+                block.buffer.resize(block.size);
+                segments.push_back({block.buffer.data(), block.size});
+                runEnd = block.offset + block.size;
+            }
+
+            bool ok = container.file->readv(runOffset, segments.data(), segments.size()) ==
+                      runEnd - runOffset;
+            for (size_t i = first; i < last; ++i) {
+                fetched[i] = ok;
+            }
+            first = last;
+        }
+
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            auto &block = blocks[i];
+            std::call_once(container.blockOnce[i], [&]() {
+                if (fetched[i]) {
+                    block.data = block.buffer.data();
+                } else {
+                    block.buffer = {};
+                }
+            });
         }
+    }
 
-        // Check header
-        if (memcmp(header.e_ident, ELFMAG, SELFMAG) != 0) {
-            _impl->err = formatTextN("%1: Not an ELF file, sign not match\n", path);
+    static bool checkIdent(const unsigned char *ident, const fs::path &path, std::string &err) {
+        if (memcmp(ident, ELFMAG, SELFMAG) != 0) {
+            err = formatTextN("%1: Not an ELF file, sign not match\n", path);
             return false;
         }
-        if (header.e_ident[EI_CLASS] != ELFCLASS64) {
-            _impl->err = formatTextN("%1: Not an 64-bit ELF file\n", path);
+        if (ident[EI_CLASS] != ELFCLASS32 && ident[EI_CLASS] != ELFCLASS64) {
+            err = formatTextN("%1: Unknown ELF class (%2)\n", path, ident[EI_CLASS]);
             return false;
         }
-        if (header.e_ident[EI_DATA] != ELFDATA2LSB) {
-            _impl->err = formatTextN("%1: Not a little-endian ELF file\n", path);
+        if (ident[EI_DATA] != ELFDATA2LSB && ident[EI_DATA] != ELFDATA2MSB) {
+            err = formatTextN("%1: Unknown ELF data encoding (%2)\n", path, ident[EI_DATA]);
             return false;
         }
-        if (header.e_ident[EI_VERSION] != EV_CURRENT) {
-            _impl->err =
-                formatTextN("%1: Unknown ELF version (%2)\n", path, header.e_ident[EI_VERSION]);
+        if (ident[EI_VERSION] != EV_CURRENT) {
+            err = formatTextN("%1: Unknown ELF version (%2)\n", path, ident[EI_VERSION]);
             return false;
         }
-        if (header.e_ident[EI_OSABI] != ELFOSABI_LINUX &&
-            header.e_ident[EI_OSABI] != ELFOSABI_SYSV) {
-            _impl->err = formatTextN("%1: Not a Linux ELF file\n", path);
+        if (ident[EI_OSABI] != ELFOSABI_LINUX && ident[EI_OSABI] != ELFOSABI_SYSV) {
+            err = formatTextN("%1: Not a Linux ELF file\n", path);
             return false;
         }
+        return true;
+    }
+
+    static inline ElfFile::Class identClass(const unsigned char *ident) {
+        return ident[EI_CLASS] == ELFCLASS32 ? ElfFile::Class32 : ElfFile::Class64;
+    }
+
+    static inline ByteOrder identByteOrder(const unsigned char *ident) {
+        return ident[EI_DATA] == ELFDATA2MSB ? ByteOrder::BigEndian : ByteOrder::LittleEndian;
+    }
+
+    template <class Traits>
+    static bool checkHeader(const typename Traits::Ehdr &header, const fs::path &path,
+                            ElfFile::Type &type, ElfFile::Architecture &arch, std::string &err) {
         switch (header.e_type) {
             case ET_EXEC:
-                container.type = Executable;
+                type = ElfFile::Executable;
                 break;
             case ET_DYN:
-                container.type = Dynamic;
+                type = ElfFile::Dynamic;
                 break;
             default:
-                _impl->err = formatTextN("%1: Unknown file type (%2)\n", path, header.e_type);
+                err = formatTextN("%1: Unknown file type (%2)\n", path, header.e_type);
                 return false;
         }
-        switch (header.e_machine) {
-            case EM_X86_64:
-                container.arch = AMD64;
-                break;
-            case EM_AARCH64:
-                container.arch = AArch64;
-                break;
-            case EM_RISCV:
-                container.arch = RiscV64;
-                break;
-            default:
-                _impl->err =
-                    formatTextN("%1: Unknown file architecture (%2)\n", path, header.e_machine);
+
+        bool known = true;
+        if constexpr (Traits::Class == ELFCLASS32) {
+            switch (header.e_machine) {
+                case EM_386:
+                    arch = ElfFile::I386;
+                    break;
+                case EM_ARM:
+                    arch = ElfFile::Arm;
+                    break;
+                case EM_RISCV:
+                    arch = ElfFile::RiscV32;
+                    break;
+                case EM_MIPS:
+                    arch = ElfFile::Mips;
+                    break;
+                case EM_PPC:
+                    arch = ElfFile::PowerPC;
+                    break;
+                default:
+                    known = false;
+                    break;
+            }
+        } else {
+            switch (header.e_machine) {
+                case EM_X86_64:
+                    arch = ElfFile::AMD64;
+                    break;
+                case EM_AARCH64:
+                    arch = ElfFile::AArch64;
+                    break;
+                case EM_RISCV:
+                    arch = ElfFile::RiscV64;
+                    break;
+                case EM_MIPS:
+                    arch = ElfFile::Mips64;
+                    break;
+                case EM_PPC64:
+                    arch = ElfFile::PowerPC64;
+                    break;
+                default:
+                    known = false;
+                    break;
+            }
+        }
+        if (!known) {
+            err = formatTextN("%1: Unknown file architecture (%2)\n", path, header.e_machine);
+            return false;
+        }
+
+        if (header.e_phentsize != sizeof(typename Traits::Phdr)) {
+            err = formatTextN("%1: Program Header Entry size mismatch (%2 != %3)\n", path,
+                              header.e_phentsize, sizeof(typename Traits::Phdr));
+            return false;
+        }
+        if (header.e_shentsize != sizeof(typename Traits::Shdr) && header.e_shentsize != 0) {
+            err = formatTextN("%1: Section Header Entry size mismatch (%2 != %3)\n", path,
+                              header.e_shentsize, sizeof(typename Traits::Shdr));
+            return false;
+        }
+        return true;
+    }
+
+    // File access shared by the class specific parts of load()
+    class ElfFileReader {
+    public:
+        ElfFileSharedContainer *container;
+        uint64_t fileSize;
+        std::vector<char> head;
+
+        inline bool isValidRange(uint64_t offset, uint64_t size) const {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+
+        bool readBytes(uint64_t offset, void *buf, size_t size) const {
+            if (!isValidRange(offset, size)) {
                 return false;
+            }
+            if (container->mapping) {
+                memcpy(buf, container->mapping->data() + offset, size);
+                return true;
+            }
+            if (offset + size <= head.size()) {
+                memcpy(buf, head.data() + offset, size);
+                return true;
+            }
+            return container->file->read(offset, static_cast<char *>(buf), size) == size;
         }
-        if (header.e_phentsize != sizeof(Elf64_Phdr)) {
-            _impl->err = formatTextN("%1: Program Header Entry size mismatch (%2 != %3)\n", path,
-                                     header.e_phentsize, sizeof(Elf64_Phdr));
+
+        bool readTable(uint64_t offset, uint64_t size, std::vector<char> &table) const {
+            if (!isValidRange(offset, size)) {
+                return false;
+            }
+            table.resize(size_t(size));
+            return readBytes(offset, table.data(), table.size());
+        }
+    };
+
+    template <class Traits>
+    static bool readHeaders(const ElfFileReader &reader, ElfFileSharedContainer &container,
+                            const fs::path &path, std::string &err) {
+        using Ehdr = typename Traits::Ehdr;
+        using Phdr = typename Traits::Phdr;
+        using Shdr = typename Traits::Shdr;
+
+        // Read header
+        Ehdr header;
+        if (!reader.readBytes(0, &header, sizeof(header))) {
+            err = formatTextN("%1: Failed to read ELF header", path);
             return false;
         }
-        if (header.e_shentsize != sizeof(Elf64_Shdr) && header.e_shentsize != 0) {
-            _impl->err = formatTextN("%1: Section Header Entry size mismatch (%2 != %3)\n", path,
-                                     header.e_shentsize, sizeof(Elf64_Shdr));
+        Traits::toHost(header);
+
+        if (!checkHeader<Traits>(header, path, container.type, container.arch, err)) {
             return false;
         }
+        container.elfClass = Traits::Class == ELFCLASS32 ? ElfFile::Class32 : ElfFile::Class64;
+        container.byteOrder = Traits::Order;
+        container.entry = header.e_entry;
 
-        // Read section headers
-        if (header.e_shentsize != 0) {
-            auto readSection = [&](::Elf64_Shdr &section) {
-                file.read(reinterpret_cast<char *>(&section), sizeof(section));
-                if (!file.good()) {
-                    _impl->err = formatTextN("%1: Failed to read section header", path);
-                    return false;
+        // Read program headers
+        {
+            std::vector<char> table;
+            if (!reader.readTable(header.e_phoff, uint64_t(header.e_phnum) * sizeof(Phdr), table)) {
+                err = formatTextN("%1: Failed to read program header", path);
+                return false;
+            }
+
+            container.programHeaders.reserve(header.e_phnum);
+
+            for (size_t i = 0; i < header.e_phnum; ++i) {
+                Phdr section;
+                memcpy(&section, table.data() + i * sizeof(section), sizeof(section));
+                Traits::toHost(section);
+
+                auto &ph = container.programHeaders.emplace_back();
+
+                ProgramHeader::Type type = ProgramHeader::OSSpecific;
+                switch (section.p_type) {
+                    case PT_NULL:
+                        type = ProgramHeader::Null;
+                        break;
+                    case PT_LOAD:
+                        type = ProgramHeader::Loadable;
+                        break;
+                    case PT_DYNAMIC:
+                        type = ProgramHeader::DynamicLinking;
+                        break;
+                    case PT_INTERP:
+                        type = ProgramHeader::Interpreter;
+                        break;
+                    case PT_NOTE:
+                        type = ProgramHeader::Note;
+                        break;
+                    case PT_SHLIB:
+                        type = ProgramHeader::SharedLibrary;
+                        break;
+                    case PT_PHDR:
+                        type = ProgramHeader::ProgramHeaderInfo;
+                        break;
+                    case PT_LOOS:
+                        type = ProgramHeader::LowOSSpecific;
+                        break;
+                    case PT_HIOS:
+                        type = ProgramHeader::HighOSSpecific;
+                        break;
+                    case PT_LOPROC:
+                        type = ProgramHeader::LowProcessorSpecific;
+                        break;
+                    case PT_HIPROC:
+                        type = ProgramHeader::HighProcessorSpecific;
+                        break;
+                    default:
+                        break;
                 }
-                return true;
-            };
+                ph.type = type;
+                ph.osType = section.p_type;
 
-            auto readData = [&](const ::Elf64_Shdr &section, SectionHeaderData &sh) {
-                if (section.sh_size == 0) {
-                    return true;
+                int attr = 0;
+                if (section.p_flags & PF_X) {
+                    attr |= ProgramHeader::Executable;
                 }
-                auto orgOffset = file.tellg();
-                file.seekg(section.sh_offset);
-
-                sh.data.resize(section.sh_size);
-                file.read(sh.data.data(), section.sh_size);
-                file.seekg(orgOffset);
-                if (!file.good()) {
-                    _impl->err = formatTextN("%1: Failed to read section data", path);
+                if (section.p_flags & PF_W) {
+                    attr |= ProgramHeader::Writable;
+                }
+                if (section.p_flags & PF_R) {
+                    attr |= ProgramHeader::Readable;
+                }
+                ph.attr = attr;
+                ph.physicalAddress = section.p_paddr;
+                ph.virtualAddress = section.p_vaddr;
+
+                ph.memSize = section.p_memsz;
+                ph.align = section.p_align;
+
+                if (!reader.isValidRange(section.p_offset, section.p_filesz)) {
+                    err = formatTextN("%1: Failed to read program data", path);
                     return false;
                 }
-                return true;
-            };
+                ph.offset = section.p_offset;
+                ph.size = section.p_filesz;
+            }
+        }
 
+        // Read section headers
+        if (header.e_shentsize != 0) {
             // The number of entries in the section header table. The product of e_shentsize and
             // e_shnum gives the section header table's size in bytes. If a file has no section
             // header table, e_shnum holds the value zero.
             size_t sectionCount = header.e_shnum;
             if (sectionCount == 0) {
-                file.seekg(header.e_shoff);
-                ::Elf64_Shdr section;
-                if (!readSection(section)) {
+                Shdr section;
+                if (!reader.readBytes(header.e_shoff, &section, sizeof(section))) {
+                    err = formatTextN("%1: Failed to read section header", path);
                     return false;
                 }
+                Traits::toHost(section);
                 sectionCount = section.sh_size;
             }
 
+            // The extended count comes from the file, bound it before computing the table size
+            std::vector<char> table;
+            if (sectionCount > reader.fileSize / sizeof(Shdr) ||
+                !reader.readTable(header.e_shoff, uint64_t(sectionCount) * sizeof(Shdr), table)) {
+                err = formatTextN("%1: Failed to read section header", path);
+                return false;
+            }
+
             std::vector<size_t> nameIndexes;
             nameIndexes.reserve(sectionCount);
             container.sectionHeaders.reserve(sectionCount);
 
-            file.seekg(header.e_shoff);
-            for (int i = 0; i < sectionCount; ++i) {
-                ::Elf64_Shdr section;
-                if (!readSection(section)) {
-                    return false;
-                }
+            for (size_t i = 0; i < sectionCount; ++i) {
+                Shdr section;
+                memcpy(&section, table.data() + i * sizeof(section), sizeof(section));
+                Traits::toHost(section);
 
                 nameIndexes.push_back(section.sh_name);
 
-                SectionHeaderData sh;
+                auto &sh = container.sectionHeaders.emplace_back();
                 SectionHeader::Type type = SectionHeader::OSSpecific;
                 switch (section.sh_type) {
                     case SHT_NULL:
@@ -172,6 +475,19 @@ namespace MTC {
                     case SHT_HASH:
                         type = SectionHeader::Hash;
                         break;
+                    case SHT_GNU_HASH:
+                        type = SectionHeader::GnuHash;
+                        break;
+                    case SHT_RELR:
+                    case SHT_ANDROID_RELR:
+                        type = SectionHeader::RelativeRelocation;
+                        break;
+                    case SHT_ANDROID_REL:
+                        type = SectionHeader::AndroidRelocation;
+                        break;
+                    case SHT_ANDROID_RELA:
+                        type = SectionHeader::AndroidRelocationWithAttends;
+                        break;
                     case SHT_DYNAMIC:
                         type = SectionHeader::DynamicLinking;
                         break;
@@ -224,143 +540,271 @@ namespace MTC {
                 sh.entrySize = section.sh_entsize;
 
                 if (sh.type != SectionHeader::NoBits) {
-                    if (!readData(section, sh)) {
+                    if (!reader.isValidRange(section.sh_offset, section.sh_size)) {
+                        err = formatTextN("%1: Failed to read section data", path);
                         return false;
                     }
+                    sh.offset = section.sh_offset;
+                    sh.size = section.sh_size;
                 }
-
-                container.sectionHeaders.emplace_back(sh);
             }
 
-            // Read section header names
-            if (header.e_shstrndx >= container.sectionHeaders.size() ||
-                container.sectionHeaders.at(header.e_shstrndx).type != SectionHeader::StringTable) {
-                _impl->err =
+            // Reject a bad string table index before any section data is touched
+            const auto &sectionHeaders = container.sectionHeaders;
+            if (header.e_shstrndx >= sectionHeaders.size() ||
+                sectionHeaders.at(header.e_shstrndx).type != SectionHeader::StringTable) {
+                err =
                     formatTextN("%1: Invalid section header index (%2)", path, header.e_shstrndx);
                 return false;
-            } else {
-                const auto &data = container.sectionHeaders.at(header.e_shstrndx).data;
+            }
+
+            buildDataBlocks(container);
+
+            // Read section header names
+            {
+                StringTableView strtab(container.sectionData(header.e_shstrndx));
                 for (size_t i = 0; i < container.sectionHeaders.size(); ++i) {
-                    if (nameIndexes[i] >= data.size()) {
-                        _impl->err = formatTextN("%1: Invalid name index of section %2 (%3)", path,
+                    if (nameIndexes[i] >= strtab.size()) {
+                        err = formatTextN("%1: Invalid name index of section %2 (%3)", path,
                                                  i, nameIndexes[i]);
                         return false;
                     }
-                    container.sectionHeaders[i].name = data.data() + nameIndexes[i];
+                    container.sectionHeaders[i].name = strtab.at(nameIndexes[i]);
+                }
+
+                auto &indexes = container.sectionIndexes;
+                indexes.reserve(sectionHeaders.size());
+                for (size_t i = 0; i < sectionHeaders.size(); ++i) {
+                    indexes.try_emplace(sectionHeaders[i].name, int(i));
                 }
             }
         }
+        return true;
+    }
 
-        // Read program headers
-        {
-            auto readSection = [&](::Elf64_Phdr &section) {
-                file.read(reinterpret_cast<char *>(&section), sizeof(section));
-                if (!file.good()) {
-                    _impl->err = formatTextN("%1: Failed to read program header", path);
-                    return false;
-                }
-                return true;
-            };
+    ElfFile::ElfFile() : _impl(std::make_unique<Impl>()) {
+    }
 
-            auto readData = [&](const ::Elf64_Phdr &section, ProgramHeaderData &ph) {
-                if (section.p_filesz == 0) {
-                    return true;
-                }
-                auto orgOffset = file.tellg();
-                file.seekg(section.p_offset);
-
-                ph.data.resize(section.p_filesz);
-                file.read(ph.data.data(), section.p_filesz);
-                file.seekg(orgOffset);
-                if (!file.good()) {
-                    _impl->err = formatTextN("%1: Failed to read program data", path);
-                    return false;
-                }
-                return true;
-            };
+    ElfFile::~ElfFile() {
+    }
 
-            container.programHeaders.reserve(header.e_phnum);
+    ElfFile::ElfFile(ElfFile &&other) noexcept = default;
+
+    ElfFile &ElfFile::operator=(ElfFile &&other) noexcept = default;
+
+    bool ElfFile::load(const fs::path &path, int options) const {
+        auto container = std::make_shared<ElfFileSharedContainer>();
+        container->path = path;
 
-            file.seekg(header.e_phoff);
-            for (int i = 0; i < header.e_phnum; ++i) {
-                ::Elf64_Phdr section;
-                if (!readSection(section)) {
+        uint64_t fileSize;
+        if (options & MapFile) {
+            auto mapping = std::make_unique<MappedFile>();
+            if (!mapping->open(path)) {
+                _impl->err = formatTextN("%1: Failed to map file", path);
+                return false;
+            }
+            fileSize = mapping->size();
+            container->mapping = std::move(mapping);
+        } else {
+            auto file = std::make_unique<RandomAccessFile>();
+            if (!file->open(path)) {
+                _impl->err = formatTextN("%1: Failed to open file", path);
+                return false;
+            }
+            fileSize = file->size();
+            container->file = std::move(file);
+        }
+
+        ElfFileReader reader{container.get(), fileSize, {}};
+
+        // The ELF header and usually the program header table sit at the start of the file, so
+        // one read at the start serves both
+        if (container->file) {
+            auto &head = reader.head;
+            head.resize(size_t(std::min<uint64_t>(fileSize, HeadReadSize)));
+            if (container->file->read(0, head.data(), head.size()) != head.size()) {
+                head.clear();
+            }
+        }
+
+        // The class and byte order select the parser once, everything below it is specialized
+        unsigned char ident[EI_NIDENT];
+        if (!reader.readBytes(0, ident, sizeof(ident))) {
+            _impl->err = formatTextN("%1: Failed to read ELF header", path);
+            return false;
+        }
+        if (!checkIdent(ident, path, _impl->err)) {
+            return false;
+        }
+        bool ok = visitElfTraits(identClass(ident), identByteOrder(ident), [&](auto traits) {
+            return readHeaders<decltype(traits)>(reader, *container, path, _impl->err);
+        });
+        if (!ok) {
+            return false;
+        }
+
+        // No section headers to resolve names from, segments still need their blocks
+        if (!container->blockOnce) {
+            buildDataBlocks(*container);
+        }
+
+        if (options & Preload) {
+            if (container->file) {
+                preloadBlocks(*container);
+            }
+            for (size_t i = 0; i < container->blocks.size(); ++i) {
+                if (!container->fetchBlock(i).data) {
+                    _impl->err = formatTextN("%1: Failed to read file data", path);
                     return false;
                 }
+            }
 
-                ProgramHeaderData ph;
+            // Everything is in memory, no need to hold the file any longer
+            container->file.reset();
+        } else if (container->file) {
+            // Loading many files must not run out of descriptors
+            container->file->close();
+        }
 
-                ProgramHeader::Type type = ProgramHeader::OSSpecific;
-                switch (section.p_type) {
-                    case PT_NULL:
-                        type = ProgramHeader::Null;
-                        break;
-                    case PT_LOAD:
-                        type = ProgramHeader::Loadable;
-                        break;
-                    case PT_DYNAMIC:
-                        type = ProgramHeader::DynamicLinking;
-                        break;
-                    case PT_INTERP:
-                        type = ProgramHeader::Interpreter;
-                        break;
-                    case PT_NOTE:
-                        type = ProgramHeader::Note;
-                        break;
-                    case PT_SHLIB:
-                        type = ProgramHeader::SharedLibrary;
-                        break;
-                    case PT_PHDR:
-                        type = ProgramHeader::ProgramHeaderInfo;
-                        break;
-                    case PT_LOOS:
-                        type = ProgramHeader::LowOSSpecific;
-                        break;
-                    case PT_HIOS:
-                        type = ProgramHeader::HighOSSpecific;
-                        break;
-                    case PT_LOPROC:
-                        type = ProgramHeader::LowProcessorSpecific;
-                        break;
-                    case PT_HIPROC:
-                        type = ProgramHeader::HighProcessorSpecific;
-                        break;
-                    default:
-                        break;
-                }
-                ph.type = type;
-                ph.osType = section.p_type;
+        _impl->container = std::move(container);
+        return true;
+    }
 
-                int attr = 0;
-                if (section.p_flags & PF_X) {
-                    attr |= ProgramHeader::Executable;
-                }
-                if (section.p_flags & PF_W) {
-                    attr |= ProgramHeader::Writable;
+    template <class Traits>
+    static bool probeHeaders(const RandomAccessFile &file, const char *head, size_t headSize,
+                             const fs::path &path, ElfFile::ProbeResult &res) {
+        using Phdr = typename Traits::Phdr;
+        using Shdr = typename Traits::Shdr;
+
+        auto fileSize = file.size();
+        auto isValidRange = [&](uint64_t offset, uint64_t size) {
+            return offset <= fileSize && size <= fileSize - offset;
+        };
+
+        // Walks a header table in fixed-size chunks, so that nothing is allocated
+        auto checkTable = [&](uint64_t offset, size_t count, auto entry, auto check) {
+            using Entry = decltype(entry);
+            if (count > fileSize / sizeof(Entry) ||
+                !isValidRange(offset, uint64_t(count) * sizeof(Entry))) {
+                return false;
+            }
+            Entry chunk[64];
+            for (size_t i = 0; i < count; i += std::size(chunk)) {
+                auto n = std::min(count - i, std::size(chunk));
+                auto bytes = n * sizeof(Entry);
+                if (file.read(offset + i * sizeof(Entry), reinterpret_cast<char *>(chunk),
+                              bytes) != bytes) {
+                    return false;
                 }
-                if (section.p_flags & PF_R) {
-                    attr |= ProgramHeader::Readable;
+                for (size_t j = 0; j < n; ++j) {
+                    Traits::toHost(chunk[j]);
+                    if (!check(i + j, chunk[j])) {
+                        return false;
+                    }
                 }
-                ph.attr = attr;
-                ph.physicalAddress = section.p_paddr;
-                ph.virtualAddress = section.p_vaddr;
+            }
+            return true;
+        };
 
-                ph.memSize = section.p_memsz;
-                ph.align = section.p_align;
+        typename Traits::Ehdr header;
+        if (headSize < sizeof(header)) {
+            res.errorMessage = formatTextN("%1: Failed to read ELF header", path);
+            return false;
+        }
+        memcpy(&header, head, sizeof(header));
+        Traits::toHost(header);
+        if (!checkHeader<Traits>(header, path, res.type, res.arch, res.errorMessage)) {
+            return false;
+        }
+
+        bool ok = checkTable(header.e_phoff, header.e_phnum, Phdr(), [&](size_t, const Phdr &ph) {
+            return isValidRange(ph.p_offset, ph.p_filesz);
+        });
+        if (!ok) {
+            res.errorMessage = formatTextN("%1: Invalid program header", path);
+            return false;
+        }
 
-                if (!readData(section, ph)) {
+        if (header.e_shentsize != 0) {
+            size_t sectionCount = header.e_shnum;
+            if (sectionCount == 0) {
+                Shdr section;
+                if (!isValidRange(header.e_shoff, sizeof(section)) ||
+                    file.read(header.e_shoff, reinterpret_cast<char *>(&section),
+                              sizeof(section)) != sizeof(section)) {
+                    res.errorMessage = formatTextN("%1: Failed to read section header", path);
                     return false;
                 }
+                Traits::toHost(section);
+                sectionCount = section.sh_size;
+            }
 
-                container.programHeaders.emplace_back(ph);
+            ok = checkTable(header.e_shoff, sectionCount, Shdr(), [&](size_t i, const Shdr &sh) {
+                if (i == header.e_shstrndx && sh.sh_type != SHT_STRTAB) {
+                    return false;
+                }
+                return sh.sh_type == SHT_NOBITS || isValidRange(sh.sh_offset, sh.sh_size);
+            });
+            if (!ok || header.e_shstrndx >= sectionCount) {
+                res.errorMessage = formatTextN("%1: Invalid section header", path);
+                return false;
             }
         }
-
-        container.path = path;
-        _impl->container = std::make_shared<decltype(container)>(std::move(container));
         return true;
     }
 
+    ElfFile::ProbeResult ElfFile::probe(const fs::path &path) {
+        ProbeResult res;
+
+        RandomAccessFile file;
+        if (!file.open(path)) {
+            res.errorMessage = formatTextN("%1: Failed to open file", path);
+            return res;
+        }
+
+        // Large enough for the header of either class
+        char head[sizeof(Elf64_Ehdr)];
+        auto headSize = file.read(0, head, sizeof(head));
+        if (headSize < EI_NIDENT) {
+            res.errorMessage = formatTextN("%1: Failed to read ELF header", path);
+            return res;
+        }
+
+        auto ident = reinterpret_cast<const unsigned char *>(head);
+        if (!checkIdent(ident, path, res.errorMessage)) {
+            return res;
+        }
+        res.elfClass = identClass(ident);
+        res.byteOrder = identByteOrder(ident);
+        res.valid = visitElfTraits(res.elfClass, res.byteOrder, [&](auto traits) {
+            return probeHeaders<decltype(traits)>(file, head, headSize, path, res);
+        });
+        return res;
+    }
+
+    std::vector<ElfFile> ElfFile::loadMany(const std::vector<fs::path> &paths, int threads,
+                                           int options) {
+        std::vector<ElfFile> res(paths.size());
+        if (paths.empty()) {
+            return res;
+        }
+        if (threads <= 0 || size_t(threads) > paths.size()) {
+            threads = int(std::min<size_t>(
+                paths.size(), std::max(1U, std::thread::hardware_concurrency())));
+        }
+
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.start([&, i]() { res[i].load(paths[i], options); });
+        }
+        pool.waitForDone();
+        return res;
+    }
+
+    bool ElfFile::isValid() const {
+        return _impl->container != nullptr;
+    }
+
     fs::path ElfFile::filePath() const {
         if (!_impl->container)
             return {};
@@ -371,6 +815,18 @@ namespace MTC {
         return _impl->err;
     }
 
+    ElfFile::Class ElfFile::elfClass() const {
+        if (!_impl->container)
+            return {};
+        return _impl->container->elfClass;
+    }
+
+    ByteOrder ElfFile::byteOrder() const {
+        if (!_impl->container)
+            return {};
+        return _impl->container->byteOrder;
+    }
+
     ElfFile::Type ElfFile::type() const {
         if (!_impl->container)
             return {};
@@ -383,6 +839,12 @@ namespace MTC {
         return _impl->container->arch;
     }
 
+    uint64_t ElfFile::entryPoint() const {
+        if (!_impl->container)
+            return 0;
+        return _impl->container->entry;
+    }
+
     int ElfFile::programHeaderCount() const {
         if (!_impl->container)
             return {};
@@ -415,4 +877,43 @@ namespace MTC {
         return res;
     }
 
-}
\ No newline at end of file
+    int ElfFile::findSection(std::string_view name) const {
+        if (!_impl->container)
+            return -1;
+
+        const auto &indexes = _impl->container->sectionIndexes;
+        auto it = indexes.find(name);
+        if (it == indexes.end())
+            return -1;
+        return it->second;
+    }
+
+    SegmentRef ElfFile::segment(int index) const {
+        return SegmentRef(_impl->container.get(), size_t(index));
+    }
+
+    SectionRef ElfFile::section(int index) const {
+        return SectionRef(_impl->container.get(), size_t(index));
+    }
+
+    ElfRange<SegmentRef> ElfFile::segments() const {
+        if (!_impl->container)
+            return {};
+        const auto &container = _impl->container;
+        return ElfRange<SegmentRef>(container.get(), container->programHeaders.size());
+    }
+
+    ElfRange<SectionRef> ElfFile::sections() const {
+        if (!_impl->container)
+            return {};
+        const auto &container = _impl->container;
+        return ElfRange<SectionRef>(container.get(), container->sectionHeaders.size());
+    }
+
+    AddressSpace ElfFile::addressSpace() const {
+        if (!_impl->container)
+            return {};
+        return AddressSpace(_impl->container);
+    }
+
+}
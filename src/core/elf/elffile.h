@@ -2,8 +2,12 @@
 #define ELFFILE_H
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <filesystem>
 
+#include <mtccore/addressspace.h>
+#include <mtccore/byteorder.h>
 #include <mtccore/programheader.h>
 #include <mtccore/sectionheader.h>
 
@@ -14,35 +18,99 @@ namespace MTC {
         ElfFile();
         ~ElfFile();
 
+        ElfFile(ElfFile &&other) noexcept;
+        ElfFile &operator=(ElfFile &&other) noexcept;
+
         enum Type {
             Executable,
             Dynamic,
         };
 
+        enum Class {
+            Class32,
+            Class64,
+        };
+
         enum Architecture {
             AMD64,
             AArch64,
             RiscV64,
+            I386,
+            Arm,
+            RiscV32,
+            Mips,
+            Mips64,
+            PowerPC,
+            PowerPC64,
+        };
+
+        enum LoadOption {
+            NoLoadOption = 0,
+            MapFile = 0x1,
+            Preload = 0x2,
+        };
+
+        class ProbeResult {
+        public:
+            bool valid = false;
+            Class elfClass = Class64;
+            ByteOrder byteOrder = ByteOrder::LittleEndian;
+            Type type = Executable;
+            Architecture arch = AMD64;
+            std::string errorMessage;
         };
 
     public:
-        bool load(const std::filesystem::path &path) const;
+        bool load(const std::filesystem::path &path, int options = NoLoadOption) const;
+
+        // Loads every path on a shared thread pool, results are in input order and failed files
+        // carry their own error message. Without MapFile or Preload, loaded files hold no open
+        // handle and reopen the path to fetch data on first access.
+        static std::vector<ElfFile> loadMany(const std::vector<std::filesystem::path> &paths,
+                                             int threads = 0, int options = NoLoadOption);
+
+        // Checks the ELF header and the header tables against the file size, without reading
+        // any section or segment data
+        static ProbeResult probe(const std::filesystem::path &path);
+
+        bool isValid() const;
 
         std::filesystem::path filePath() const;
         std::string errorMessage() const;
 
+        Class elfClass() const;
+        ByteOrder byteOrder() const;
         Type type() const;
         Architecture architecture() const;
 
+        // Virtual address of the entry point, 0 if the file has none
+        uint64_t entryPoint() const;
+
         int programHeaderCount() const;
         ProgramHeader programHeader(int index) const;
 
         int sectionHeaderCount() const;
         SectionHeader sectionHeader(int index) const;
 
+        // Index of the first section with the given name, or -1
+        int findSection(std::string_view name) const;
+
+        // Unchecked, non-owning access, the references are valid while this file is alive
+        SegmentRef segment(int index) const;
+        SectionRef section(int index) const;
+
+        ElfRange<SegmentRef> segments() const;
+        ElfRange<SectionRef> sections() const;
+
+        // Index of the loadable segments by virtual address, fetches their data when the file
+        // is read lazily
+        AddressSpace addressSpace() const;
+
     protected:
         class Impl;
         std::unique_ptr<Impl> _impl;
+
+        friend class ElfDynamic;
     };
 
 }
@@ -2,8 +2,13 @@
 #define ELFFILE_P_H
 
 #include <vector>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 
 #include <mtccore/elffile.h>
+#include <mtccore/mappedfile.h>
+#include <mtccore/randomaccessfile.h>
 #include <mtccore/programheader.h>
 #include <mtccore/sectionheader.h>
 
@@ -18,35 +23,86 @@ namespace MTC {
         uintptr_t virtualAddress{};
         size_t memSize{};
         size_t align{};
-        std::vector<char> data;
+
+        // File range, a view into the data block that covers it
+        uint64_t offset{};
+        size_t size{};
+        size_t block{};
     };
 
     class SectionHeaderData {
     public:
-        std::string name;
+        // Points into the section header string table
+        std::string_view name;
         SectionHeader::Type type{};
         size_t osType{};
         int attr{};
         uintptr_t address{};
         size_t addressAlign{};
-        std::vector<char> data;
+
+        // File range, a view into the data block that covers it
+        uint64_t offset{};
+        size_t size{};
+        size_t block{};
 
         uint32_t link{};
         uint32_t info{};
         uint64_t entrySize{};
     };
 
+    class DataBlock {
+    public:
+        uint64_t offset{};
+        size_t size{};
+
+        // Null until fetched, or if fetching failed
+        const char *data{};
+        std::vector<char> buffer;
+    };
+
     class ElfFileSharedContainer {
     public:
         std::filesystem::path path;
 
+        ElfFile::Class elfClass{};
+        ByteOrder byteOrder{};
         ElfFile::Type type{};
         ElfFile::Architecture arch{};
+        uint64_t entry{};
 
         std::vector<ProgramHeaderData> programHeaders;
         std::vector<SectionHeaderData> sectionHeaders;
 
-        std::vector<std::string> sectionHeaderStringTable;
+        // First section of each name
+        std::unordered_map<std::string_view, int> sectionIndexes;
+
+        // Keeps the section and segment data alive when the file is mapped
+        std::unique_ptr<MappedFile> mapping;
+
+        // Source of lazily fetched data when the file is not mapped. It is only open while
+        // loading, later fetches open the path for each block so that loaded files hold no
+        // descriptor.
+        std::unique_ptr<RandomAccessFile> file;
+
+        // Disjoint file ranges backing the section and segment data, fetched on first access
+        std::vector<DataBlock> blocks;
+        std::unique_ptr<std::once_flag[]> blockOnce;
+
+        const DataBlock &fetchBlock(size_t index);
+        std::string_view entryData(size_t block, uint64_t offset, size_t size);
+
+        // Bytes of an arbitrary file range, empty unless a single data block covers it
+        std::string_view fileData(uint64_t offset, size_t size);
+
+        inline std::string_view programData(size_t index) {
+            const auto &ph = programHeaders.at(index);
+            return entryData(ph.block, ph.offset, ph.size);
+        }
+
+        inline std::string_view sectionData(size_t index) {
+            const auto &sh = sectionHeaders.at(index);
+            return entryData(sh.block, sh.offset, sh.size);
+        }
     };
 
     class ElfFile::Impl {
@@ -0,0 +1,99 @@
+#ifndef ELFRANGE_H
+#define ELFRANGE_H
+
+#include <cstddef>
+#include <iterator>
+
+namespace MTC {
+
+    class ElfFileSharedContainer;
+
+    // Iterable sequence of the lightweight section or segment references of an ElfFile, valid
+    // as long as the file is alive.
+    template <class Ref>
+    class ElfRange {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Ref;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Ref *;
+            using reference = const Ref &;
+
+            const_iterator() = default;
+
+            inline reference operator*() const {
+                return _ref;
+            }
+
+            inline pointer operator->() const {
+                return &_ref;
+            }
+
+            inline const_iterator &operator++() {
+                ++_ref._index;
+                return *this;
+            }
+
+            inline const_iterator operator++(int) {
+                auto org = *this;
+                ++_ref._index;
+                return org;
+            }
+
+            inline bool operator==(const const_iterator &other) const {
+                return _ref._index == other._ref._index;
+            }
+
+            inline bool operator!=(const const_iterator &other) const {
+                return _ref._index != other._ref._index;
+            }
+
+        private:
+            inline explicit const_iterator(const Ref &ref) : _ref(ref) {
+            }
+
+            Ref _ref;
+
+            friend class ElfRange;
+        };
+
+    public:
+        ElfRange() : _container(nullptr), _count(0) {
+        }
+
+        inline size_t size() const {
+            return _count;
+        }
+
+        inline bool empty() const {
+            return _count == 0;
+        }
+
+        inline Ref operator[](size_t index) const {
+            return Ref(_container, index);
+        }
+
+        inline const_iterator begin() const {
+            return const_iterator(Ref(_container, 0));
+        }
+
+        inline const_iterator end() const {
+            return const_iterator(Ref(_container, _count));
+        }
+
+    protected:
+        inline ElfRange(ElfFileSharedContainer *container, size_t count)
+            : _container(container), _count(count) {
+        }
+
+        ElfFileSharedContainer *_container;
+        size_t _count;
+
+        friend class ElfFile;
+    };
+
+}
+
+#endif // ELFRANGE_H
@@ -0,0 +1,230 @@
+#ifndef ELFTRAITS_P_H
+#define ELFTRAITS_P_H
+
+#include <cstdint>
+
+#include <mtccore/byteorder.h>
+#include <mtccore/elffile.h>
+
+#include "elf.h"
+
+namespace MTC {
+
+    // In-place conversion of every field of an ELF structure
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf32_Ehdr &h) {
+        h.e_type = toHostOrder<Order>(h.e_type);
+        h.e_machine = toHostOrder<Order>(h.e_machine);
+        h.e_version = toHostOrder<Order>(h.e_version);
+        h.e_entry = toHostOrder<Order>(h.e_entry);
+        h.e_phoff = toHostOrder<Order>(h.e_phoff);
+        h.e_shoff = toHostOrder<Order>(h.e_shoff);
+        h.e_flags = toHostOrder<Order>(h.e_flags);
+        h.e_ehsize = toHostOrder<Order>(h.e_ehsize);
+        h.e_phentsize = toHostOrder<Order>(h.e_phentsize);
+        h.e_phnum = toHostOrder<Order>(h.e_phnum);
+        h.e_shentsize = toHostOrder<Order>(h.e_shentsize);
+        h.e_shnum = toHostOrder<Order>(h.e_shnum);
+        h.e_shstrndx = toHostOrder<Order>(h.e_shstrndx);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf64_Ehdr &h) {
+        h.e_type = toHostOrder<Order>(h.e_type);
+        h.e_machine = toHostOrder<Order>(h.e_machine);
+        h.e_version = toHostOrder<Order>(h.e_version);
+        h.e_entry = toHostOrder<Order>(h.e_entry);
+        h.e_phoff = toHostOrder<Order>(h.e_phoff);
+        h.e_shoff = toHostOrder<Order>(h.e_shoff);
+        h.e_flags = toHostOrder<Order>(h.e_flags);
+        h.e_ehsize = toHostOrder<Order>(h.e_ehsize);
+        h.e_phentsize = toHostOrder<Order>(h.e_phentsize);
+        h.e_phnum = toHostOrder<Order>(h.e_phnum);
+        h.e_shentsize = toHostOrder<Order>(h.e_shentsize);
+        h.e_shnum = toHostOrder<Order>(h.e_shnum);
+        h.e_shstrndx = toHostOrder<Order>(h.e_shstrndx);
+    }
+
+    template <ByteOrder Order, class Phdr>
+    inline void toHostOrderPhdr(Phdr &p) {
+        p.p_type = toHostOrder<Order>(p.p_type);
+        p.p_flags = toHostOrder<Order>(p.p_flags);
+        p.p_offset = toHostOrder<Order>(p.p_offset);
+        p.p_vaddr = toHostOrder<Order>(p.p_vaddr);
+        p.p_paddr = toHostOrder<Order>(p.p_paddr);
+        p.p_filesz = toHostOrder<Order>(p.p_filesz);
+        p.p_memsz = toHostOrder<Order>(p.p_memsz);
+        p.p_align = toHostOrder<Order>(p.p_align);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf32_Phdr &p) {
+        toHostOrderPhdr<Order>(p);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf64_Phdr &p) {
+        toHostOrderPhdr<Order>(p);
+    }
+
+    template <ByteOrder Order, class Shdr>
+    inline void toHostOrderShdr(Shdr &s) {
+        s.sh_name = toHostOrder<Order>(s.sh_name);
+        s.sh_type = toHostOrder<Order>(s.sh_type);
+        s.sh_flags = toHostOrder<Order>(s.sh_flags);
+        s.sh_addr = toHostOrder<Order>(s.sh_addr);
+        s.sh_offset = toHostOrder<Order>(s.sh_offset);
+        s.sh_size = toHostOrder<Order>(s.sh_size);
+        s.sh_link = toHostOrder<Order>(s.sh_link);
+        s.sh_info = toHostOrder<Order>(s.sh_info);
+        s.sh_addralign = toHostOrder<Order>(s.sh_addralign);
+        s.sh_entsize = toHostOrder<Order>(s.sh_entsize);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf32_Shdr &s) {
+        toHostOrderShdr<Order>(s);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf64_Shdr &s) {
+        toHostOrderShdr<Order>(s);
+    }
+
+    template <ByteOrder Order, class Sym>
+    inline void toHostOrderSym(Sym &s) {
+        s.st_name = toHostOrder<Order>(s.st_name);
+        s.st_shndx = toHostOrder<Order>(s.st_shndx);
+        s.st_value = toHostOrder<Order>(s.st_value);
+        s.st_size = toHostOrder<Order>(s.st_size);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf32_Sym &s) {
+        toHostOrderSym<Order>(s);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf64_Sym &s) {
+        toHostOrderSym<Order>(s);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf32_Dyn &d) {
+        d.d_tag = toHostOrder<Order>(d.d_tag);
+        d.d_un.d_val = toHostOrder<Order>(d.d_un.d_val);
+    }
+
+    template <ByteOrder Order>
+    inline void toHostOrderFields(Elf64_Dyn &d) {
+        d.d_tag = toHostOrder<Order>(d.d_tag);
+        d.d_un.d_val = toHostOrder<Order>(d.d_un.d_val);
+    }
+
+    // Layout of one ELF class and byte order, parsers are instantiated once per combination so
+    // that the per-entry loops never branch on either. Structures copied out of the file are
+    // passed through toHost(), which compiles to nothing when the order matches the host.
+    template <ByteOrder O>
+    class Elf32Traits {
+    public:
+        static constexpr const int Class = ELFCLASS32;
+        static constexpr const ByteOrder Order = O;
+
+        using Ehdr = Elf32_Ehdr;
+        using Phdr = Elf32_Phdr;
+        using Shdr = Elf32_Shdr;
+        using Sym = Elf32_Sym;
+        using Rel = Elf32_Rel;
+        using Rela = Elf32_Rela;
+        using Dyn = Elf32_Dyn;
+        using Word = uint32_t;
+        using SignedWord = int32_t;
+
+        template <class T>
+        static inline void toHost(T &value) {
+            if constexpr (Order != HostByteOrder) {
+                toHostOrderFields<Order>(value);
+            }
+        }
+
+        template <class T>
+        static inline T load(const char *data) {
+            return loadValue<Order, T>(data);
+        }
+
+        static inline uint32_t relocationType(uint64_t info) {
+            return uint32_t(ELF32_R_TYPE(info));
+        }
+
+        static inline uint32_t relocationSymbol(uint64_t info) {
+            return uint32_t(ELF32_R_SYM(info));
+        }
+    };
+
+    template <ByteOrder O>
+    class Elf64Traits {
+    public:
+        static constexpr const int Class = ELFCLASS64;
+        static constexpr const ByteOrder Order = O;
+
+        using Ehdr = Elf64_Ehdr;
+        using Phdr = Elf64_Phdr;
+        using Shdr = Elf64_Shdr;
+        using Sym = Elf64_Sym;
+        using Rel = Elf64_Rel;
+        using Rela = Elf64_Rela;
+        using Dyn = Elf64_Dyn;
+        using Word = uint64_t;
+        using SignedWord = int64_t;
+
+        template <class T>
+        static inline void toHost(T &value) {
+            if constexpr (Order != HostByteOrder) {
+                toHostOrderFields<Order>(value);
+            }
+        }
+
+        template <class T>
+        static inline T load(const char *data) {
+            return loadValue<Order, T>(data);
+        }
+
+        static inline uint32_t relocationType(uint64_t info) {
+            return uint32_t(ELF64_R_TYPE(info));
+        }
+
+        static inline uint32_t relocationSymbol(uint64_t info) {
+            return uint32_t(ELF64_R_SYM(info));
+        }
+    };
+
+    // Calls the visitor with the traits matching a loaded file
+    template <class Visitor>
+    inline auto visitElfTraits(ElfFile::Class elfClass, ByteOrder order, Visitor visitor) {
+        if (elfClass == ElfFile::Class32) {
+            if (order == ByteOrder::BigEndian) {
+                return visitor(Elf32Traits<ByteOrder::BigEndian>());
+            }
+            return visitor(Elf32Traits<ByteOrder::LittleEndian>());
+        }
+        if (order == ByteOrder::BigEndian) {
+            return visitor(Elf64Traits<ByteOrder::BigEndian>());
+        }
+        return visitor(Elf64Traits<ByteOrder::LittleEndian>());
+    }
+
+    // Widens a symbol to the canonical 64-bit layout
+    inline Elf64_Sym canonicalSymbol(const Elf32_Sym &sym) {
+        Elf64_Sym res;
+        res.st_name = sym.st_name;
+        res.st_info = sym.st_info;
+        res.st_other = sym.st_other;
+        res.st_shndx = sym.st_shndx;
+        res.st_value = sym.st_value;
+        res.st_size = sym.st_size;
+        return res;
+    }
+
+}
+
+#endif // ELFTRAITS_P_H
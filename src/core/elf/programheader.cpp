@@ -57,14 +57,47 @@ namespace MTC {
         if (!_container) {
             return {};
         }
-        return _container->programHeaders.at(_index).data.data();
+        return _container->programData(_index).data();
     }
 
     size_t ProgramHeader::dataSize() const {
         if (!_container) {
             return {};
         }
-        return _container->programHeaders.at(_index).data.size();
+        return _container->programData(_index).size();
     }
 
-}
\ No newline at end of file
+    SegmentRef::Type SegmentRef::type() const {
+        return _container->programHeaders[_index].type;
+    }
+
+    size_t SegmentRef::osType() const {
+        return _container->programHeaders[_index].osType;
+    }
+
+    int SegmentRef::attributes() const {
+        return _container->programHeaders[_index].attr;
+    }
+
+    uintptr_t SegmentRef::physicalAddress() const {
+        return _container->programHeaders[_index].physicalAddress;
+    }
+
+    uintptr_t SegmentRef::virtualAddress() const {
+        return _container->programHeaders[_index].virtualAddress;
+    }
+
+    size_t SegmentRef::memorySize() const {
+        return _container->programHeaders[_index].memSize;
+    }
+
+    size_t SegmentRef::align() const {
+        return _container->programHeaders[_index].align;
+    }
+
+    std::string_view SegmentRef::data() const {
+        const auto &ph = _container->programHeaders[_index];
+        return _container->entryData(ph.block, ph.offset, ph.size);
+    }
+
+}
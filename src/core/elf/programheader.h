@@ -2,9 +2,11 @@
 #define PROGRAMHEADER_H
 
 #include <string>
+#include <string_view>
 #include <memory>
 
 #include <mtccore/mtccoreglobal.h>
+#include <mtccore/elfrange.h>
 
 namespace MTC {
 
@@ -34,9 +36,9 @@ namespace MTC {
         };
 
         enum Attribute {
-            Executable,
-            Writable,
-            Readable,
+            Executable = 0x1,
+            Writable = 0x2,
+            Readable = 0x4,
         };
 
     public:
@@ -59,6 +61,50 @@ namespace MTC {
         friend class ElfFile;
     };
 
+    // Non-owning counterpart of ProgramHeader for hot paths, it neither checks the index nor
+    // holds a reference on the file, which must outlive it.
+    class MTC_CORE_EXPORT SegmentRef {
+    public:
+        using Type = ProgramHeader::Type;
+
+        SegmentRef() : _container(nullptr), _index(0) {
+        }
+
+    public:
+        inline bool isNull() const;
+        inline int index() const;
+
+        Type type() const;
+        size_t osType() const;
+        int attributes() const;
+        uintptr_t physicalAddress() const;
+        uintptr_t virtualAddress() const;
+
+        size_t memorySize() const;
+        size_t align() const;
+
+        std::string_view data() const;
+
+    protected:
+        inline SegmentRef(ElfFileSharedContainer *container, size_t index)
+            : _container(container), _index(index) {
+        }
+
+        ElfFileSharedContainer *_container;
+        size_t _index;
+
+        friend class ElfFile;
+        friend class ElfRange<SegmentRef>;
+    };
+
+    inline bool SegmentRef::isNull() const {
+        return _container == nullptr;
+    }
+
+    inline int SegmentRef::index() const {
+        return int(_index);
+    }
+
 }
 
 #endif // PROGRAMHEADER_H
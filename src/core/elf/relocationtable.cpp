@@ -0,0 +1,631 @@
+#include "relocationtable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "elf.h"
+#include "elffile_p.h"
+#include "elftraits_p.h"
+
+namespace MTC {
+
+    // Per-architecture handlers, each describes the relative type that dominates position
+    // independent binaries and how to compute every other supported type. Targets are read and
+    // written in the byte order of the image.
+    template <ByteOrder Order>
+    class AMD64Relocator {
+    public:
+        static constexpr const ByteOrder TargetOrder = Order;
+        using Word = uint64_t;
+        static constexpr const uint32_t Relative = R_X86_64_RELATIVE;
+
+        static inline bool apply(uint32_t type, char *p, uint64_t place, uint64_t s, int64_t a) {
+            switch (type) {
+                case R_X86_64_NONE:
+                    return true;
+                case R_X86_64_64:
+                    storeValue<Order, uint64_t>(p, s + a);
+                    return true;
+                case R_X86_64_PC32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a - place));
+                    return true;
+                case R_X86_64_GLOB_DAT:
+                case R_X86_64_JUMP_SLOT:
+                    storeValue<Order, uint64_t>(p, s);
+                    return true;
+                case R_X86_64_32:
+                case R_X86_64_32S:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a));
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static inline size_t width(uint32_t type) {
+            switch (type) {
+                case R_X86_64_PC32:
+                case R_X86_64_32:
+                case R_X86_64_32S:
+                    return 4;
+                default:
+                    break;
+            }
+            return 8;
+        }
+    };
+
+    template <ByteOrder Order>
+    class AArch64Relocator {
+    public:
+        static constexpr const ByteOrder TargetOrder = Order;
+        using Word = uint64_t;
+        static constexpr const uint32_t Relative = R_AARCH64_RELATIVE;
+
+        static inline bool apply(uint32_t type, char *p, uint64_t place, uint64_t s, int64_t a) {
+            switch (type) {
+                case R_AARCH64_NONE:
+                    return true;
+                case R_AARCH64_ABS64:
+                case R_AARCH64_GLOB_DAT:
+                case R_AARCH64_JUMP_SLOT:
+                    storeValue<Order, uint64_t>(p, s + a);
+                    return true;
+                case R_AARCH64_ABS32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a));
+                    return true;
+                case R_AARCH64_PREL64:
+                    storeValue<Order, uint64_t>(p, s + a - place);
+                    return true;
+                case R_AARCH64_PREL32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a - place));
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static inline size_t width(uint32_t type) {
+            switch (type) {
+                case R_AARCH64_ABS32:
+                case R_AARCH64_PREL32:
+                    return 4;
+                default:
+                    break;
+            }
+            return 8;
+        }
+    };
+
+    // Shared by RV32 and RV64, the jump slot is as wide as the word
+    template <ByteOrder Order, class W>
+    class RiscVRelocator {
+    public:
+        static constexpr const ByteOrder TargetOrder = Order;
+        using Word = W;
+        static constexpr const uint32_t Relative = R_RISCV_RELATIVE;
+
+        static inline bool apply(uint32_t type, char *p, uint64_t, uint64_t s, int64_t a) {
+            switch (type) {
+                case R_RISCV_NONE:
+                    return true;
+                case R_RISCV_64:
+                    storeValue<Order, uint64_t>(p, s + a);
+                    return true;
+                case R_RISCV_32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a));
+                    return true;
+                case R_RISCV_JUMP_SLOT:
+                    storeValue<Order, Word>(p, Word(s));
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static inline size_t width(uint32_t type) {
+            switch (type) {
+                case R_RISCV_32:
+                    return 4;
+                case R_RISCV_64:
+                    return 8;
+                default:
+                    break;
+            }
+            return sizeof(Word);
+        }
+    };
+
+    template <ByteOrder Order>
+    using RiscV64Relocator = RiscVRelocator<Order, uint64_t>;
+
+    template <ByteOrder Order>
+    using RiscV32Relocator = RiscVRelocator<Order, uint32_t>;
+
+    template <ByteOrder Order>
+    class I386Relocator {
+    public:
+        static constexpr const ByteOrder TargetOrder = Order;
+        using Word = uint32_t;
+        static constexpr const uint32_t Relative = R_386_RELATIVE;
+
+        static inline bool apply(uint32_t type, char *p, uint64_t place, uint64_t s, int64_t a) {
+            switch (type) {
+                case R_386_NONE:
+                    return true;
+                case R_386_32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a));
+                    return true;
+                case R_386_PC32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a - place));
+                    return true;
+                case R_386_GLOB_DAT:
+                case R_386_JMP_SLOT:
+                    storeValue<Order, uint32_t>(p, uint32_t(s));
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static inline size_t width(uint32_t) {
+            return 4;
+        }
+    };
+
+    template <ByteOrder Order>
+    class ArmRelocator {
+    public:
+        static constexpr const ByteOrder TargetOrder = Order;
+        using Word = uint32_t;
+        static constexpr const uint32_t Relative = R_ARM_RELATIVE;
+
+        static inline bool apply(uint32_t type, char *p, uint64_t place, uint64_t s, int64_t a) {
+            switch (type) {
+                case R_ARM_NONE:
+                    return true;
+                case R_ARM_ABS32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a));
+                    return true;
+                case R_ARM_REL32:
+                    storeValue<Order, uint32_t>(p, uint32_t(s + a - place));
+                    return true;
+                case R_ARM_GLOB_DAT:
+                case R_ARM_JUMP_SLOT:
+                    storeValue<Order, uint32_t>(p, uint32_t(s));
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static inline size_t width(uint32_t) {
+            return 4;
+        }
+    };
+
+    // Stands in for architectures without a handler, every entry is reported as skipped
+    class UnsupportedRelocator {
+    public:
+        using Word = uint64_t;
+        static constexpr const uint32_t Relative = 0;
+    };
+
+    // Calls the handler instantiated for the architecture and byte order
+    template <ByteOrder Order, class Handler>
+    static inline int dispatchRelocator(ElfFile::Architecture arch, Handler handler) {
+        switch (arch) {
+            case ElfFile::AMD64:
+                return handler(AMD64Relocator<Order>());
+            case ElfFile::AArch64:
+                return handler(AArch64Relocator<Order>());
+            case ElfFile::RiscV64:
+                return handler(RiscV64Relocator<Order>());
+            case ElfFile::I386:
+                return handler(I386Relocator<Order>());
+            case ElfFile::Arm:
+                return handler(ArmRelocator<Order>());
+            case ElfFile::RiscV32:
+                return handler(RiscV32Relocator<Order>());
+            default:
+                break;
+        }
+        return handler(UnsupportedRelocator());
+    }
+
+    template <class Handler>
+    static inline int dispatchRelocator(ElfFile::Architecture arch, ByteOrder byteOrder,
+                                        Handler handler) {
+        if (byteOrder == ByteOrder::BigEndian) {
+            return dispatchRelocator<ByteOrder::BigEndian>(arch, handler);
+        }
+        return dispatchRelocator<ByteOrder::LittleEndian>(arch, handler);
+    }
+
+    // Applies one entry to the image, the addend is read from the target when not explicit
+    template <class Relocator>
+    static inline bool applyEntry(const RelocationImage &image, uint64_t offset, uint32_t type,
+                                  uint32_t sym, const int64_t *addend,
+                                  const uint64_t *symbolValues, size_t symbolCount) {
+        if (offset < image.address) {
+            return false;
+        }
+        auto pos = offset - image.address;
+        auto p = image.data + pos;
+
+        // Relative entries dominate PIE binaries, keep them on the straight path
+        using Word = typename Relocator::Word;
+        constexpr auto Order = Relocator::TargetOrder;
+        if (type == Relocator::Relative) {
+            if (pos + sizeof(Word) > image.size) {
+                return false;
+            }
+            auto a = addend ? *addend
+                            : int64_t(std::make_signed_t<Word>(loadValue<Order, Word>(p)));
+            storeValue<Order, Word>(p, Word(image.loadBias + a));
+            return true;
+        }
+
+        auto width = Relocator::width(type);
+        if (pos + width > image.size || (sym != STN_UNDEF && sym >= symbolCount)) {
+            return false;
+        }
+
+        int64_t a;
+        if (addend) {
+            a = *addend;
+        } else {
+            a = width == 4 ? int64_t(loadValue<Order, int32_t>(p)) : loadValue<Order, int64_t>(p);
+        }
+        uint64_t s = sym != STN_UNDEF ? symbolValues[sym] : 0;
+        // The place is where the target ends up at run time
+        return Relocator::apply(type, p, image.loadBias + offset, s, a);
+    }
+
+    template <>
+    inline bool applyEntry<UnsupportedRelocator>(const RelocationImage &, uint64_t, uint32_t,
+                                                 uint32_t, const int64_t *, const uint64_t *,
+                                                 size_t) {
+        return false;
+    }
+
+    template <class Relocator>
+    static int applyRelocations(const uint64_t *offsets, const uint32_t *types,
+                                const uint32_t *symbols, const int64_t *addends, size_t count,
+                                const RelocationImage &image, const uint64_t *symbolValues,
+                                size_t symbolCount) {
+        // Entries are sorted, so the ones targeting the image form a contiguous run
+        auto first = size_t(std::lower_bound(offsets, offsets + count, image.address) - offsets);
+        auto last = size_t(std::lower_bound(offsets + first, offsets + count,
+                                            image.address + image.size) -
+                           offsets);
+
+        int skipped = 0;
+        for (size_t i = first; i < last; ++i) {
+            if (!applyEntry<Relocator>(image, offsets[i], types[i], symbols[i],
+                                       addends ? addends + i : nullptr, symbolValues,
+                                       symbolCount)) {
+                ++skipped;
+            }
+        }
+        return skipped;
+    }
+
+    template <class Relocator>
+    static int applyRelr(RelrDecoder decoder, const RelocationImage &image) {
+        int skipped = 0;
+        uint64_t offset;
+        while (decoder.next(offset)) {
+            if (offset < image.address || offset >= image.address + image.size) {
+                continue;
+            }
+            if (!applyEntry<Relocator>(image, offset, Relocator::Relative, STN_UNDEF, nullptr,
+                                       nullptr, 0)) {
+                ++skipped;
+            }
+        }
+        return skipped;
+    }
+
+    template <class Relocator>
+    static int applyAndroid(AndroidRelocationDecoder decoder, bool hasAddends,
+                            const RelocationImage &image, const uint64_t *symbolValues,
+                            size_t symbolCount) {
+        int skipped = 0;
+        RelocationEntry entry;
+        while (decoder.next(entry)) {
+            if (entry.offset < image.address || entry.offset >= image.address + image.size) {
+                continue;
+            }
+            if (!applyEntry<Relocator>(image, entry.offset, entry.type, entry.symbol,
+                                       hasAddends ? &entry.addend : nullptr, symbolValues,
+                                       symbolCount)) {
+                ++skipped;
+            }
+        }
+        return skipped;
+    }
+
+    // Reads .rel/.rela entries of one class into canonical 64-bit arrays
+    template <class Traits>
+    static size_t decodeRelocations(std::string_view data, bool hasAddends,
+                                    std::vector<uint64_t> &offsets, std::vector<uint32_t> &types,
+                                    std::vector<uint32_t> &symbols, std::vector<int64_t> &addends) {
+        using Rela = typename Traits::Rela;
+        using Word = typename Traits::Word;
+        using SignedWord = typename Traits::SignedWord;
+
+        auto entrySize = hasAddends ? sizeof(Rela) : sizeof(typename Traits::Rel);
+        auto count = data.size() / entrySize;
+        offsets.resize(count);
+        types.resize(count);
+        symbols.resize(count);
+        addends.resize(hasAddends ? count : 0);
+        for (size_t i = 0; i < count; ++i) {
+            auto entry = data.data() + i * entrySize;
+            offsets[i] = Traits::template load<Word>(entry + offsetof(Rela, r_offset));
+            auto info = uint64_t(Traits::template load<Word>(entry + offsetof(Rela, r_info)));
+            types[i] = Traits::relocationType(info);
+            symbols[i] = Traits::relocationSymbol(info);
+            if (hasAddends) {
+                addends[i] = Traits::template load<SignedWord>(entry + offsetof(Rela, r_addend));
+            }
+        }
+        return count;
+    }
+
+    RelocationTable::RelocationTable() : _valid(false), _hasAddends(false) {
+    }
+
+    RelocationTable::RelocationTable(const SectionHeader &section) : RelocationTable() {
+        auto type = section.type();
+        if (type != SectionHeader::RelocationWithAttends && type != SectionHeader::Relocation) {
+            return;
+        }
+        _hasAddends = type == SectionHeader::RelocationWithAttends;
+
+        auto data = std::string_view(section.data(), section.dataSize());
+        size_t count;
+        std::vector<uint64_t> offsets;
+        std::vector<uint32_t> types;
+        std::vector<uint32_t> symbols;
+        std::vector<int64_t> addends;
+        auto elfClass = section._container ? section._container->elfClass : ElfFile::Class64;
+        auto byteOrder = section._container ? section._container->byteOrder : HostByteOrder;
+        count = visitElfTraits(elfClass, byteOrder, [&](auto traits) {
+            return decodeRelocations<decltype(traits)>(data, _hasAddends, offsets, types, symbols,
+                                                       addends);
+        });
+
+        // Dynamic relocations are usually emitted in order, only permute when needed
+        if (std::is_sorted(offsets.begin(), offsets.end())) {
+            _offsets = std::move(offsets);
+            _types = std::move(types);
+            _symbols = std::move(symbols);
+            _addends = std::move(addends);
+        } else {
+            std::vector<size_t> order(count);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+                return offsets[lhs] < offsets[rhs];
+            });
+
+            _offsets.resize(count);
+            _types.resize(count);
+            _symbols.resize(count);
+            _addends.resize(addends.size());
+            for (size_t i = 0; i < count; ++i) {
+                auto j = order[i];
+                _offsets[i] = offsets[j];
+                _types[i] = types[j];
+                _symbols[i] = symbols[j];
+                if (_hasAddends) {
+                    _addends[i] = addends[j];
+                }
+            }
+        }
+        _valid = true;
+    }
+
+    RelocationTable::~RelocationTable() = default;
+
+    bool RelocationTable::isValid() const {
+        return _valid;
+    }
+
+    bool RelocationTable::hasAddends() const {
+        return _hasAddends;
+    }
+
+    int RelocationTable::apply(ElfFile::Architecture arch, const RelocationImage &image,
+                               const uint64_t *symbolValues, size_t symbolCount) const {
+        auto addends = _hasAddends ? _addends.data() : nullptr;
+        return dispatchRelocator(arch, image.byteOrder, [&](auto relocator) {
+            return applyRelocations<decltype(relocator)>(_offsets.data(), _types.data(),
+                                                         _symbols.data(), addends, _offsets.size(),
+                                                         image, symbolValues, symbolCount);
+        });
+    }
+
+    RelrDecoder::RelrDecoder() : RelrDecoder(std::string_view()) {
+    }
+
+    RelrDecoder::RelrDecoder(std::string_view data, ElfFile::Class elfClass, ByteOrder byteOrder)
+        : _data(data), _pos(data.data()), _end(data.data() + data.size()), _elfClass(elfClass),
+          _byteOrder(byteOrder), _wordSize(elfClass == ElfFile::Class32 ? 4 : 8), _base(0),
+          _bitmap(0), _bit(0) {
+    }
+
+    int RelrDecoder::apply(ElfFile::Architecture arch, const RelocationImage &image) const {
+        return dispatchRelocator(arch, image.byteOrder, [&](auto relocator) {
+            return applyRelr<decltype(relocator)>(RelrDecoder(_data, _elfClass, _byteOrder), image);
+        });
+    }
+
+    // Group flags of the APS2 encoding
+    enum {
+        RELOCATION_GROUPED_BY_INFO_FLAG = 1,
+        RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG = 2,
+        RELOCATION_GROUPED_BY_ADDEND_FLAG = 4,
+        RELOCATION_GROUP_HAS_ADDEND_FLAG = 8,
+    };
+
+    AndroidRelocationDecoder::AndroidRelocationDecoder()
+        : _pos(nullptr), _end(nullptr), _hasAddends(false), _elfClass(ElfFile::Class64),
+          _valid(false), _count(0), _index(0), _groupSize(0), _groupIndex(0), _groupFlags(0),
+          _groupOffsetDelta(0), _offset(0), _info(0), _addend(0) {
+    }
+
+    AndroidRelocationDecoder::AndroidRelocationDecoder(std::string_view data, bool hasAddends,
+                                                       ElfFile::Class elfClass)
+        : AndroidRelocationDecoder() {
+        _elfClass = elfClass;
+        if (data.size() < 4 || memcmp(data.data(), "APS2", 4) != 0) {
+            return;
+        }
+        _data = data;
+        _pos = data.data() + 4;
+        _end = data.data() + data.size();
+        _hasAddends = hasAddends;
+
+        int64_t count;
+        int64_t offset;
+        if (!readNumber(count) || !readNumber(offset) || count < 0) {
+            return;
+        }
+        _count = size_t(count);
+        _offset = uint64_t(offset);
+        _valid = true;
+    }
+
+    bool AndroidRelocationDecoder::isValid() const {
+        return _valid;
+    }
+
+    size_t AndroidRelocationDecoder::count() const {
+        return _count;
+    }
+
+    bool AndroidRelocationDecoder::readNumber(int64_t &value) {
+        // SLEB128
+        uint64_t res = 0;
+        int shift = 0;
+        uint8_t byte;
+        do {
+            if (_pos == _end || shift >= 64) {
+                _valid = false;
+                return false;
+            }
+            byte = uint8_t(*_pos++);
+            res |= uint64_t(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        if (shift < 64 && (byte & 0x40)) {
+            res |= ~uint64_t(0) << shift;
+        }
+        value = int64_t(res);
+        return true;
+    }
+
+    bool AndroidRelocationDecoder::readGroup() {
+        int64_t size;
+        int64_t flags;
+        if (!readNumber(size) || !readNumber(flags) || size <= 0) {
+            _valid = false;
+            return false;
+        }
+        _groupSize = size_t(size);
+        _groupFlags = uint64_t(flags);
+        _groupIndex = 0;
+
+        int64_t value;
+        if (_groupFlags & RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG) {
+            if (!readNumber(value)) {
+                return false;
+            }
+            _groupOffsetDelta = uint64_t(value);
+        }
+        if (_groupFlags & RELOCATION_GROUPED_BY_INFO_FLAG) {
+            if (!readNumber(value)) {
+                return false;
+            }
+            _info = uint64_t(value);
+        }
+
+        if ((_groupFlags & RELOCATION_GROUP_HAS_ADDEND_FLAG) &&
+            (_groupFlags & RELOCATION_GROUPED_BY_ADDEND_FLAG)) {
+            if (!_hasAddends || !readNumber(value)) {
+                _valid = false;
+                return false;
+            }
+            _addend += value;
+        } else if (!(_groupFlags & RELOCATION_GROUP_HAS_ADDEND_FLAG)) {
+            _addend = 0;
+        }
+        return true;
+    }
+
+    bool AndroidRelocationDecoder::next(RelocationEntry &entry) {
+        if (!_valid || _index >= _count) {
+            return false;
+        }
+        if (_groupIndex == _groupSize && !readGroup()) {
+            return false;
+        }
+
+        int64_t value;
+        if (_groupFlags & RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG) {
+            _offset += _groupOffsetDelta;
+        } else {
+            if (!readNumber(value)) {
+                return false;
+            }
+            _offset += uint64_t(value);
+        }
+        if (!(_groupFlags & RELOCATION_GROUPED_BY_INFO_FLAG)) {
+            if (!readNumber(value)) {
+                return false;
+            }
+            _info = uint64_t(value);
+        }
+        if ((_groupFlags & RELOCATION_GROUP_HAS_ADDEND_FLAG) &&
+            !(_groupFlags & RELOCATION_GROUPED_BY_ADDEND_FLAG)) {
+            if (!_hasAddends || !readNumber(value)) {
+                _valid = false;
+                return false;
+            }
+            _addend += value;
+        }
+
+        entry.offset = _offset;
+        if (_elfClass == ElfFile::Class32) {
+            entry.type = uint32_t(ELF32_R_TYPE(_info));
+            entry.symbol = uint32_t(ELF32_R_SYM(_info));
+        } else {
+            entry.type = uint32_t(ELF64_R_TYPE(_info));
+            entry.symbol = uint32_t(ELF64_R_SYM(_info));
+        }
+        entry.addend = _addend;
+
+        ++_groupIndex;
+        ++_index;
+        return true;
+    }
+
+    int AndroidRelocationDecoder::apply(ElfFile::Architecture arch, const RelocationImage &image,
+                                        const uint64_t *symbolValues, size_t symbolCount) const {
+        AndroidRelocationDecoder decoder(_data, _hasAddends, _elfClass);
+        return dispatchRelocator(arch, image.byteOrder, [&](auto relocator) {
+            return applyAndroid<decltype(relocator)>(decoder, _hasAddends, image, symbolValues,
+                                                     symbolCount);
+        });
+    }
+
+}
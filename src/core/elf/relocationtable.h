@@ -0,0 +1,209 @@
+#ifndef RELOCATIONTABLE_H
+#define RELOCATIONTABLE_H
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <mtccore/elffile.h>
+
+namespace MTC {
+
+    // Writable copy of a virtual address range that relocations are applied to
+    class RelocationImage {
+    public:
+        char *data = nullptr;
+        size_t size = 0;
+
+        // Virtual address of data[0]
+        uint64_t address = 0;
+
+        // Difference between the load address and the link-time address (B)
+        uint64_t loadBias = 0;
+
+        // Byte order of data, the one of the file it was copied from
+        ByteOrder byteOrder = HostByteOrder;
+    };
+
+    class RelocationEntry {
+    public:
+        uint64_t offset = 0;
+        uint32_t type = 0;
+        uint32_t symbol = 0;
+        int64_t addend = 0;
+    };
+
+    // Decoded .rel/.rela section in structure-of-arrays form, sorted by target offset
+    class MTC_CORE_EXPORT RelocationTable {
+    public:
+        RelocationTable();
+        explicit RelocationTable(const SectionHeader &section);
+        ~RelocationTable();
+
+    public:
+        bool isValid() const;
+        bool hasAddends() const;
+
+        inline int count() const;
+        inline const uint64_t *offsets() const;
+        inline const uint32_t *types() const;
+        inline const uint32_t *symbols() const;
+        inline const int64_t *addends() const;
+
+        // Applies all entries targeting the image, symbolValues holds the resolved value (S)
+        // of each symbol index. Entries of unsupported types or architectures, or with
+        // unresolved symbols, are left untouched; returns the number of such entries inside the
+        // image.
+        int apply(ElfFile::Architecture arch, const RelocationImage &image,
+                  const uint64_t *symbolValues, size_t symbolCount) const;
+
+    protected:
+        bool _valid;
+        bool _hasAddends;
+
+        std::vector<uint64_t> _offsets;
+        std::vector<uint32_t> _types;
+        std::vector<uint32_t> _symbols;
+        std::vector<int64_t> _addends;
+    };
+
+    // Streaming decoder of a packed relative relocation section (.relr.dyn), every entry is
+    // expanded on the fly and nothing is materialized. Entries are words of the file class.
+    class MTC_CORE_EXPORT RelrDecoder {
+    public:
+        RelrDecoder();
+        explicit RelrDecoder(std::string_view data, ElfFile::Class elfClass = ElfFile::Class64,
+                             ByteOrder byteOrder = ByteOrder::LittleEndian);
+
+    public:
+        // Next relocated address, in increasing order
+        inline bool next(uint64_t &offset);
+
+        // Applies the relative relocations targeting the image from the start of the section,
+        // their addends are implicit
+        int apply(ElfFile::Architecture arch, const RelocationImage &image) const;
+
+    private:
+        std::string_view _data;
+        const char *_pos;
+        const char *_end;
+        ElfFile::Class _elfClass;
+        ByteOrder _byteOrder;
+        size_t _wordSize;
+
+        uint64_t _base;
+        uint64_t _bitmap;
+        int _bit;
+    };
+
+    // Streaming decoder of an Android packed relocation section (APS2)
+    class MTC_CORE_EXPORT AndroidRelocationDecoder {
+    public:
+        AndroidRelocationDecoder();
+        AndroidRelocationDecoder(std::string_view data, bool hasAddends,
+                                 ElfFile::Class elfClass = ElfFile::Class64);
+
+    public:
+        bool isValid() const;
+        size_t count() const;
+
+        bool next(RelocationEntry &entry);
+
+        // Applies the relocations targeting the image from the start of the section
+        int apply(ElfFile::Architecture arch, const RelocationImage &image,
+                  const uint64_t *symbolValues, size_t symbolCount) const;
+
+    private:
+        std::string_view _data;
+        const char *_pos;
+        const char *_end;
+        bool _hasAddends;
+        ElfFile::Class _elfClass;
+        bool _valid;
+
+        size_t _count;
+        size_t _index;
+
+        size_t _groupSize;
+        size_t _groupIndex;
+        uint64_t _groupFlags;
+        uint64_t _groupOffsetDelta;
+
+        uint64_t _offset;
+        uint64_t _info;
+        int64_t _addend;
+
+        bool readNumber(int64_t &value);
+        bool readGroup();
+    };
+
+    inline bool RelrDecoder::next(uint64_t &offset) {
+        while (true) {
+            // Remaining bits of the current bitmap entry, bit i relocates the word i - 1 past
+            // the base
+            while (_bitmap && _bit < int(_wordSize * 8)) {
+                auto i = _bit++;
+                if ((_bitmap >> i) == 0) {
+                    break;
+                }
+                if ((_bitmap >> i) & 1) {
+                    offset = _base + (i - 1) * _wordSize;
+                    return true;
+                }
+            }
+            if (_bitmap) {
+                _bitmap = 0;
+                _base += (_wordSize * 8 - 1) * _wordSize;
+            }
+
+            if (size_t(_end - _pos) < _wordSize) {
+                return false;
+            }
+            uint64_t entry;
+            if (_wordSize == 4) {
+                uint32_t word;
+                memcpy(&word, _pos, 4);
+                entry = _byteOrder == HostByteOrder ? word : byteSwap(word);
+            } else {
+                memcpy(&entry, _pos, 8);
+                entry = _byteOrder == HostByteOrder ? entry : byteSwap(entry);
+            }
+            _pos += _wordSize;
+
+            // An even entry is an address and sets the base of the following bitmaps
+            if ((entry & 1) == 0) {
+                offset = entry;
+                _base = entry + _wordSize;
+                return true;
+            }
+
+            // An odd entry is a bitmap of the next 31 or 63 words
+            _bitmap = entry;
+            _bit = 1;
+        }
+    }
+
+    inline int RelocationTable::count() const {
+        return int(_offsets.size());
+    }
+
+    inline const uint64_t *RelocationTable::offsets() const {
+        return _offsets.data();
+    }
+
+    inline const uint32_t *RelocationTable::types() const {
+        return _types.data();
+    }
+
+    inline const uint32_t *RelocationTable::symbols() const {
+        return _symbols.data();
+    }
+
+    inline const int64_t *RelocationTable::addends() const {
+        return _addends.data();
+    }
+
+}
+
+#endif // RELOCATIONTABLE_H
@@ -9,7 +9,7 @@ namespace MTC {
         if (!_container) {
             return {};
         }
-        return _container->sectionHeaders.at(_index).name;
+        return std::string(_container->sectionHeaders.at(_index).name);
     }
 
     SectionHeader::Type SectionHeader::type() const {
@@ -44,14 +44,14 @@ namespace MTC {
         if (!_container) {
             return {};
         }
-        return _container->sectionHeaders.at(_index).data.data();
+        return _container->sectionData(_index).data();
     }
 
     size_t SectionHeader::dataSize() const {
         if (!_container) {
             return {};
         }
-        return _container->sectionHeaders.at(_index).data.size();
+        return _container->sectionData(_index).size();
     }
 
     uint32_t SectionHeader::link() const {
@@ -86,8 +86,60 @@ namespace MTC {
         if (!_container) {
             return {};
         }
-        const auto &data = _container->sectionHeaders.at(_index).data;
+        auto data = _container->sectionData(_index);
         return extractNullSeperatedStrings(data.data(), data.size());
     }
 
-}
\ No newline at end of file
+    StringTableView SectionHeader::asStringTableView() const {
+        if (!_container) {
+            return {};
+        }
+        return StringTableView(_container->sectionData(_index));
+    }
+
+    SymbolTable SectionHeader::asSymbolTable() const {
+        return MTC::SymbolTable(*this);
+    }
+
+    std::string_view SectionRef::name() const {
+        return _container->sectionHeaders[_index].name;
+    }
+
+    SectionRef::Type SectionRef::type() const {
+        return _container->sectionHeaders[_index].type;
+    }
+
+    size_t SectionRef::osType() const {
+        return _container->sectionHeaders[_index].osType;
+    }
+
+    int SectionRef::attributes() const {
+        return _container->sectionHeaders[_index].attr;
+    }
+
+    uintptr_t SectionRef::address() const {
+        return _container->sectionHeaders[_index].address;
+    }
+
+    std::string_view SectionRef::data() const {
+        const auto &sh = _container->sectionHeaders[_index];
+        return _container->entryData(sh.block, sh.offset, sh.size);
+    }
+
+    uint32_t SectionRef::link() const {
+        return _container->sectionHeaders[_index].link;
+    }
+
+    uint32_t SectionRef::info() const {
+        return _container->sectionHeaders[_index].info;
+    }
+
+    size_t SectionRef::addressAlign() const {
+        return _container->sectionHeaders[_index].addressAlign;
+    }
+
+    size_t SectionRef::entrySize() const {
+        return _container->sectionHeaders[_index].entrySize;
+    }
+
+}
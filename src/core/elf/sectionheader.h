@@ -2,10 +2,14 @@
 #define SECTIONHEADER_H
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 
 #include <mtccore/mtccoreglobal.h>
+#include <mtccore/symboltable.h>
+#include <mtccore/stringtableview.h>
+#include <mtccore/elfrange.h>
 
 namespace MTC {
 
@@ -13,6 +17,8 @@ namespace MTC {
 
     class ElfFileSharedContainer;
 
+    class RelocationTable;
+
     class MTC_CORE_EXPORT SectionHeader {
     public:
         SectionHeader() : _index(0) {
@@ -37,12 +43,16 @@ namespace MTC {
             LowUserSpecific,
             HighUserSpecific,
             OSSpecific,
+            GnuHash,
+            RelativeRelocation,
+            AndroidRelocation,
+            AndroidRelocationWithAttends,
         };
 
         enum Attribute {
-            Writable,
-            AllocationRequired,
-            Executable,
+            Writable = 0x1,
+            AllocationRequired = 0x2,
+            Executable = 0x4,
         };
 
     public:
@@ -61,14 +71,64 @@ namespace MTC {
         size_t entrySize() const;
 
         std::vector<std::string> asStringTable() const;
+        StringTableView asStringTableView() const;
+        MTC::SymbolTable asSymbolTable() const;
 
     protected:
         std::shared_ptr<ElfFileSharedContainer> _container;
         size_t _index;
 
         friend class ElfFile;
+        friend class MTC::SymbolTable;
+        friend class RelocationTable;
+    };
+
+    // Non-owning counterpart of SectionHeader for hot paths, it neither checks the index nor
+    // holds a reference on the file, which must outlive it.
+    class MTC_CORE_EXPORT SectionRef {
+    public:
+        using Type = SectionHeader::Type;
+
+        SectionRef() : _container(nullptr), _index(0) {
+        }
+
+    public:
+        inline bool isNull() const;
+        inline int index() const;
+
+        std::string_view name() const;
+        Type type() const;
+        size_t osType() const;
+        int attributes() const;
+        uintptr_t address() const;
+
+        std::string_view data() const;
+
+        uint32_t link() const;
+        uint32_t info() const;
+        size_t addressAlign() const;
+        size_t entrySize() const;
+
+    protected:
+        inline SectionRef(ElfFileSharedContainer *container, size_t index)
+            : _container(container), _index(index) {
+        }
+
+        ElfFileSharedContainer *_container;
+        size_t _index;
+
+        friend class ElfFile;
+        friend class ElfRange<SectionRef>;
     };
 
+    inline bool SectionRef::isNull() const {
+        return _container == nullptr;
+    }
+
+    inline int SectionRef::index() const {
+        return int(_index);
+    }
+
 }
 
 #endif // SECTIONHEADER_H
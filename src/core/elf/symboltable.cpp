@@ -0,0 +1,345 @@
+#include "symboltable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "elffile_p.h"
+#include "elftraits_p.h"
+
+namespace MTC {
+
+    class SymbolNameIndex {
+    public:
+        std::once_flag once;
+        std::unordered_map<std::string_view, int> indexes;
+    };
+
+    // Hash sections of a foreign byte order, converted to host order once
+    class HashTableCopy {
+    public:
+        std::vector<uint64_t> gnuHash;
+        std::vector<uint32_t> hash;
+
+        std::string_view convertGnuHash(std::string_view data, ElfFile::Class elfClass) {
+            if (data.size() < 16) {
+                return {};
+            }
+            gnuHash.resize((data.size() + 7) / 8);
+            auto bytes = reinterpret_cast<char *>(gnuHash.data());
+            memcpy(bytes, data.data(), data.size());
+
+            // Header and bloom filter words, then 32-bit buckets and chains
+            auto words = reinterpret_cast<uint32_t *>(bytes);
+            byteSwapArray(words, 4);
+            size_t bloomBytes = size_t(words[2]) * (elfClass == ElfFile::Class32 ? 4 : 8);
+            bloomBytes = std::min(bloomBytes, data.size() - 16);
+            if (elfClass == ElfFile::Class32) {
+                byteSwapArray(words + 4, bloomBytes / 4);
+            } else {
+                byteSwapArray(reinterpret_cast<uint64_t *>(bytes + 16), bloomBytes / 8);
+            }
+            auto rest = 16 + bloomBytes;
+            byteSwapArray(reinterpret_cast<uint32_t *>(bytes + rest), (data.size() - rest) / 4);
+            return {bytes, data.size()};
+        }
+
+        std::string_view convertHash(std::string_view data) {
+            hash.resize(data.size() / 4);
+            memcpy(hash.data(), data.data(), hash.size() * 4);
+            byteSwapArray(hash.data(), hash.size());
+            return {reinterpret_cast<const char *>(hash.data()), hash.size() * 4};
+        }
+    };
+
+    template <class Traits>
+    static void readSymbols(std::string_view data, std::vector<Elf64_Sym> &symbols) {
+        using Sym = typename Traits::Sym;
+        auto count = data.size() / sizeof(Sym);
+        symbols.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            Sym sym;
+            memcpy(&sym, data.data() + i * sizeof(sym), sizeof(sym));
+            Traits::toHost(sym);
+            if constexpr (Traits::Class == ELFCLASS32) {
+                symbols[i] = canonicalSymbol(sym);
+            } else {
+                symbols[i] = sym;
+            }
+        }
+    }
+
+    template <class T>
+    static inline T loadWord(const char *data) {
+        T res;
+        memcpy(&res, data, sizeof(T));
+        return res;
+    }
+
+    static uint32_t gnuHash(std::string_view name) {
+        uint32_t h = 5381;
+        for (auto ch : name) {
+            h = (h << 5) + h + uint8_t(ch);
+        }
+        return h;
+    }
+
+    static uint32_t sysvHash(std::string_view name) {
+        uint32_t h = 0;
+        for (auto ch : name) {
+            h = (h << 4) + uint8_t(ch);
+            uint32_t g = h & 0xf0000000;
+            if (g) {
+                h ^= g >> 24;
+            }
+            h &= ~g;
+        }
+        return h;
+    }
+
+    SymbolTable::SymbolTable() : _symbols(nullptr), _count(0) {
+    }
+
+    SymbolTable::SymbolTable(const SectionHeader &section) : SymbolTable() {
+        auto type = section.type();
+        if (!section._container ||
+            (type != SectionHeader::SymbolTable && type != SectionHeader::DynamicSymbol)) {
+            return;
+        }
+
+        auto &container = section._container;
+        auto data = container->sectionData(section._index);
+        if (section.link() >= container->sectionHeaders.size()) {
+            return;
+        }
+        _container = container;
+        _strtab = StringTableView(container->sectionData(section.link()));
+
+        size_t count;
+        if (container->elfClass == ElfFile::Class64 && container->byteOrder == HostByteOrder) {
+            count = data.size() / sizeof(Elf64_Sym);
+            if (reinterpret_cast<uintptr_t>(data.data()) % alignof(Elf64_Sym) == 0) {
+                _symbols = reinterpret_cast<const Elf64_Sym *>(data.data());
+            } else {
+                _copy = std::make_shared<std::vector<Elf64_Sym>>(count);
+                memcpy(_copy->data(), data.data(), count * sizeof(Elf64_Sym));
+                _symbols = _copy->data();
+            }
+        } else {
+            // Converted once, lookups then share the canonical path
+            _copy = std::make_shared<std::vector<Elf64_Sym>>();
+            visitElfTraits(container->elfClass, container->byteOrder, [&](auto traits) {
+                readSymbols<decltype(traits)>(data, *_copy);
+            });
+            count = _copy->size();
+            _symbols = _copy->data();
+        }
+        _count = int(count);
+
+        // Build the address index over defined function symbols
+        std::vector<int> functions;
+        for (int i = 0; i < _count; ++i) {
+            const auto &sym = _symbols[i];
+            auto symType = ELF64_ST_TYPE(sym.st_info);
+            if ((symType == STT_FUNC || symType == STT_GNU_IFUNC) && sym.st_shndx != SHN_UNDEF) {
+                functions.push_back(i);
+            }
+        }
+        std::stable_sort(functions.begin(), functions.end(), [this](int lhs, int rhs) {
+            return _symbols[lhs].st_value < _symbols[rhs].st_value;
+        });
+
+        _starts.reserve(functions.size());
+        _ends.reserve(functions.size());
+        _indexes.reserve(functions.size());
+        for (auto i : functions) {
+            const auto &sym = _symbols[i];
+            _starts.push_back(sym.st_value);
+            _ends.push_back(sym.st_value + sym.st_size);
+            _indexes.push_back(i);
+        }
+
+        // Look for the hash tables built by the linker for this symbol table
+        for (size_t i = 0; i < container->sectionHeaders.size(); ++i) {
+            const auto &sh = container->sectionHeaders[i];
+            if (sh.link != section._index) {
+                continue;
+            }
+            if (sh.type == SectionHeader::GnuHash) {
+                _gnuHash = container->sectionData(i);
+            } else if (sh.type == SectionHeader::Hash) {
+                _hash = container->sectionData(i);
+            }
+        }
+        if (container->byteOrder != HostByteOrder) {
+            _hashCopy = std::make_shared<HashTableCopy>();
+            _gnuHash = _hashCopy->convertGnuHash(_gnuHash, container->elfClass);
+            _hash = _hashCopy->convertHash(_hash);
+        }
+        _nameIndex = std::make_shared<SymbolNameIndex>();
+    }
+
+    SymbolTable::~SymbolTable() = default;
+
+    bool SymbolTable::isValid() const {
+        return _container != nullptr;
+    }
+
+    int SymbolTable::findFunction(uint64_t address) const {
+        auto it = std::upper_bound(_starts.begin(), _starts.end(), address);
+        if (it == _starts.begin()) {
+            return -1;
+        }
+
+        // Aliases share a start address, any of them may carry the size
+        auto i = size_t(it - _starts.begin()) - 1;
+        auto start = _starts[i];
+        while (true) {
+            if (address < _ends[i] || (address == start && _ends[i] == start)) {
+                return _indexes[i];
+            }
+            if (i == 0 || _starts[i - 1] != start) {
+                break;
+            }
+            --i;
+        }
+        return -1;
+    }
+
+    int SymbolTable::find(std::string_view name) const {
+        if (!_container) {
+            return -1;
+        }
+        if (!_gnuHash.empty()) {
+            auto index = findInGnuHash(name);
+            if (index >= 0) {
+                return index;
+            }
+        }
+
+        // .gnu.hash only covers the defined symbols from symoffset on, undefined and imported
+        // ones come before them
+        if (!_hash.empty()) {
+            return findInHash(name);
+        }
+        return findInNameIndex(name);
+    }
+
+    int SymbolTable::findInNameIndex(std::string_view name) const {
+        std::call_once(_nameIndex->once, [this]() {
+            // Symbols covered by .gnu.hash are found through it and left out
+            auto end = uint32_t(_count);
+            if (_gnuHash.size() >= 16) {
+                end = std::min(end, loadWord<uint32_t>(_gnuHash.data() + 4));
+            }
+
+            auto &indexes = _nameIndex->indexes;
+            indexes.reserve(end);
+            for (int i = 1; i < int(end); ++i) {
+                auto symName = this->name(i);
+                if (symName.empty()) {
+                    continue;
+                }
+
+                // Prefer a defined symbol over an undefined one of the same name
+                auto it = indexes.try_emplace(symName, i).first;
+                if (_symbols[it->second].st_shndx == SHN_UNDEF) {
+                    it->second = i;
+                }
+            }
+        });
+
+        const auto &indexes = _nameIndex->indexes;
+        auto it = indexes.find(name);
+        if (it == indexes.end()) {
+            return -1;
+        }
+        return it->second;
+    }
+
+    int SymbolTable::findInGnuHash(std::string_view name) const {
+        // Header: nbuckets, symoffset, bloom size, bloom shift
+        const auto data = _gnuHash.data();
+        const auto size = _gnuHash.size();
+        if (size < 16) {
+            return -1;
+        }
+        auto bucketCount = loadWord<uint32_t>(data);
+        auto symOffset = loadWord<uint32_t>(data + 4);
+        auto bloomSize = loadWord<uint32_t>(data + 8);
+        auto bloomShift = loadWord<uint32_t>(data + 12);
+
+        // Bloom words are as wide as the file class
+        size_t bloomBits = _container->elfClass == ElfFile::Class32 ? 32 : 64;
+        size_t bloomOffset = 16;
+        size_t bucketOffset = bloomOffset + size_t(bloomSize) * (bloomBits / 8);
+        size_t chainOffset = bucketOffset + size_t(bucketCount) * sizeof(uint32_t);
+        if (bucketCount == 0 || bloomSize == 0 || chainOffset > size) {
+            return -1;
+        }
+
+        auto h = gnuHash(name);
+
+        // The bloom filter rejects most absent names without touching the buckets
+        auto wordPos = data + bloomOffset + (h / bloomBits % bloomSize) * (bloomBits / 8);
+        auto word = bloomBits == 64 ? loadWord<uint64_t>(wordPos) : loadWord<uint32_t>(wordPos);
+        uint64_t mask = (uint64_t(1) << (h % bloomBits)) |
+                        (uint64_t(1) << ((h >> bloomShift) % bloomBits));
+        if ((word & mask) != mask) {
+            return -1;
+        }
+
+        uint32_t index = loadWord<uint32_t>(data + bucketOffset + (h % bucketCount) * 4);
+        if (index < symOffset) {
+            return -1;
+        }
+        for (; index < uint32_t(_count); ++index) {
+            auto chainPos = chainOffset + size_t(index - symOffset) * 4;
+            if (chainPos + 4 > size) {
+                break;
+            }
+            auto h2 = loadWord<uint32_t>(data + chainPos);
+            if ((h | 1) == (h2 | 1) && this->name(int(index)) == name) {
+                return int(index);
+            }
+            // The lowest bit marks the end of the chain
+            if (h2 & 1) {
+                break;
+            }
+        }
+        return -1;
+    }
+
+    int SymbolTable::findInHash(std::string_view name) const {
+        // Header: nbucket, nchain
+        const auto data = _hash.data();
+        const auto size = _hash.size();
+        if (size < 8) {
+            return -1;
+        }
+        auto bucketCount = loadWord<uint32_t>(data);
+        auto chainCount = loadWord<uint32_t>(data + 4);
+        size_t bucketOffset = 8;
+        size_t chainOffset = bucketOffset + size_t(bucketCount) * 4;
+        if (bucketCount == 0 || chainOffset + size_t(chainCount) * 4 > size) {
+            return -1;
+        }
+
+        auto h = sysvHash(name);
+        auto index = loadWord<uint32_t>(data + bucketOffset + (h % bucketCount) * 4);
+
+        // Bounded by the chain length, a malformed table must not loop forever
+        for (uint32_t steps = 0; index != STN_UNDEF && steps < chainCount; ++steps) {
+            if (index >= chainCount || index >= uint32_t(_count)) {
+                break;
+            }
+            if (this->name(int(index)) == name) {
+                return int(index);
+            }
+            index = loadWord<uint32_t>(data + chainOffset + size_t(index) * 4);
+        }
+        return -1;
+    }
+
+}
@@ -0,0 +1,84 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <mtccore/elf.h>
+#include <mtccore/mtccoreglobal.h>
+#include <mtccore/stringtableview.h>
+
+namespace MTC {
+
+    class SectionHeader;
+
+    class ElfFileSharedContainer;
+
+    class SymbolNameIndex;
+
+    class HashTableCopy;
+
+    class MTC_CORE_EXPORT SymbolTable {
+    public:
+        SymbolTable();
+        explicit SymbolTable(const SectionHeader &section);
+        ~SymbolTable();
+
+    public:
+        bool isValid() const;
+
+        int count() const;
+        const Elf64_Sym &symbol(int index) const;
+        inline std::string_view name(int index) const;
+
+        // Index of the function symbol whose range contains the address, or -1
+        int findFunction(uint64_t address) const;
+
+        // Index of the symbol with the given name, or -1. Uses the .gnu.hash or .hash table of
+        // the file if one belongs to this table, otherwise a hash map built on first use. As
+        // .gnu.hash only covers defined symbols, the others are looked up in .hash or the map.
+        int find(std::string_view name) const;
+
+    protected:
+        std::shared_ptr<ElfFileSharedContainer> _container;
+
+        const Elf64_Sym *_symbols;
+        int _count;
+        StringTableView _strtab;
+
+        // Only used if the section data is not suitably aligned for Elf64_Sym
+        std::shared_ptr<std::vector<Elf64_Sym>> _copy;
+
+        // Function symbols sorted by start address, as parallel arrays
+        std::vector<uint64_t> _starts;
+        std::vector<uint64_t> _ends;
+        std::vector<int> _indexes;
+
+        std::string_view _gnuHash;
+        std::string_view _hash;
+
+        // Only used if the file is not in host byte order
+        std::shared_ptr<HashTableCopy> _hashCopy;
+        std::shared_ptr<SymbolNameIndex> _nameIndex;
+
+        int findInGnuHash(std::string_view name) const;
+        int findInHash(std::string_view name) const;
+        int findInNameIndex(std::string_view name) const;
+    };
+
+    inline int SymbolTable::count() const {
+        return _count;
+    }
+
+    inline const Elf64_Sym &SymbolTable::symbol(int index) const {
+        return _symbols[index];
+    }
+
+    inline std::string_view SymbolTable::name(int index) const {
+        return _strtab.at(_symbols[index].st_name);
+    }
+
+}
+
+#endif // SYMBOLTABLE_H
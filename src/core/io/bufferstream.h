@@ -0,0 +1,514 @@
+#ifndef BUFFERSTREAM_H
+#define BUFFERSTREAM_H
+
+#include <mtccore/stream.h>
+
+namespace Substate {
+
+    // Reads the IStream format straight out of memory, such as a mapped file. Every access is a
+    // bounds check and a memcpy, running past the end sets failbit and eofbit like an istream.
+    template <ByteOrder Order>
+    class BasicBufferIStream {
+    public:
+        inline BasicBufferIStream(const char *data, size_t size);
+        inline explicit BasicBufferIStream(std::string_view data);
+
+    public:
+        inline const char *data() const;
+        inline size_t size() const;
+        inline size_t pos() const;
+        inline size_t remaining() const;
+        inline bool seek(size_t pos);
+
+        inline std::ios::iostate state() const;
+        inline void setState(std::ios::iostate state);
+
+        inline bool good() const;
+        inline bool fail() const;
+
+        inline int readRawData(char *data, int len);
+        inline int skipRawData(int len);
+        inline int align(int size);
+
+        template <class T>
+        inline bool readNumbers(T *data, size_t count);
+
+        inline BasicBufferIStream &operator>>(bool &b);
+        inline BasicBufferIStream &operator>>(int8_t &c);
+        inline BasicBufferIStream &operator>>(uint8_t &uc);
+        inline BasicBufferIStream &operator>>(int16_t &s);
+        inline BasicBufferIStream &operator>>(uint16_t &us);
+        inline BasicBufferIStream &operator>>(int32_t &i);
+        inline BasicBufferIStream &operator>>(uint32_t &u);
+        inline BasicBufferIStream &operator>>(int64_t &l);
+        inline BasicBufferIStream &operator>>(uint64_t &ul);
+        inline BasicBufferIStream &operator>>(float &f);
+        inline BasicBufferIStream &operator>>(double &d);
+        inline BasicBufferIStream &operator>>(std::string &s);
+
+        // Points into the buffer instead of copying, valid as long as the buffer is
+        inline BasicBufferIStream &operator>>(std::string_view &s);
+
+    private:
+        template <class T>
+        inline void readNum(T &value);
+
+        const char *_data;
+        size_t _size;
+        size_t _pos;
+        std::ios::iostate _state;
+    };
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order>::BasicBufferIStream(const char *data, size_t size)
+        : _data(data), _size(size), _pos(0), _state(std::ios::goodbit) {
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order>::BasicBufferIStream(std::string_view data)
+        : BasicBufferIStream(data.data(), data.size()) {
+    }
+
+    template <ByteOrder Order>
+    inline const char *BasicBufferIStream<Order>::data() const {
+        return _data;
+    }
+
+    template <ByteOrder Order>
+    inline size_t BasicBufferIStream<Order>::size() const {
+        return _size;
+    }
+
+    template <ByteOrder Order>
+    inline size_t BasicBufferIStream<Order>::pos() const {
+        return _pos;
+    }
+
+    template <ByteOrder Order>
+    inline size_t BasicBufferIStream<Order>::remaining() const {
+        return _size - _pos;
+    }
+
+    template <ByteOrder Order>
+    inline bool BasicBufferIStream<Order>::seek(size_t pos) {
+        if (pos > _size) {
+            _state |= std::ios::failbit;
+            return false;
+        }
+        _pos = pos;
+        _state &= ~std::ios::eofbit;
+        return true;
+    }
+
+    template <ByteOrder Order>
+    inline std::ios::iostate BasicBufferIStream<Order>::state() const {
+        return _state;
+    }
+
+    template <ByteOrder Order>
+    inline void BasicBufferIStream<Order>::setState(std::ios::iostate state) {
+        _state |= state;
+    }
+
+    template <ByteOrder Order>
+    inline bool BasicBufferIStream<Order>::good() const {
+        return _state == std::ios::goodbit;
+    }
+
+    template <ByteOrder Order>
+    inline bool BasicBufferIStream<Order>::fail() const {
+        return (_state & (std::ios::failbit | std::ios::badbit)) != 0;
+    }
+
+    template <ByteOrder Order>
+    inline int BasicBufferIStream<Order>::readRawData(char *data, int len) {
+        if (fail() || len <= 0) {
+            return 0;
+        }
+        size_t n = std::min(size_t(len), remaining());
+        memcpy(data, _data + _pos, n);
+        _pos += n;
+        if (n < size_t(len)) {
+            _state |= std::ios::failbit | std::ios::eofbit;
+        }
+        return int(n);
+    }
+
+    template <ByteOrder Order>
+    inline int BasicBufferIStream<Order>::skipRawData(int len) {
+        if (fail() || len <= 0) {
+            return 0;
+        }
+        size_t n = std::min(size_t(len), remaining());
+        _pos += n;
+        if (n < size_t(len)) {
+            _state |= std::ios::eofbit;
+        }
+        return int(n);
+    }
+
+    template <ByteOrder Order>
+    inline int BasicBufferIStream<Order>::align(int size) {
+        auto rem = int(_pos % size);
+        if (rem == 0)
+            return 0;
+        return skipRawData(size - rem);
+    }
+
+    template <ByteOrder Order>
+    template <class T>
+    inline bool BasicBufferIStream<Order>::readNumbers(T *data, size_t count) {
+        static_assert(IsStreamNumber<T>::value);
+        if (fail() || count > remaining() / sizeof(T)) {
+            _state |= std::ios::failbit | std::ios::eofbit;
+            return false;
+        }
+        memcpy(data, _data + _pos, count * sizeof(T));
+        _pos += count * sizeof(T);
+        MTC::toHostOrderArray<Order>(data, count);
+        return true;
+    }
+
+    template <ByteOrder Order>
+    template <class T>
+    inline void BasicBufferIStream<Order>::readNum(T &value) {
+        if (fail() || remaining() < sizeof(T)) {
+            _state |= std::ios::failbit | std::ios::eofbit;
+            value = 0;
+            return;
+        }
+        value = MTC::loadValue<Order, T>(_data + _pos);
+        _pos += sizeof(T);
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(bool &b) {
+        int8_t c;
+        readNum(c);
+        b = good() && c;
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(int8_t &c) {
+        readNum(c);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(uint8_t &uc) {
+        readNum(uc);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(int16_t &s) {
+        readNum(s);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(uint16_t &us) {
+        readNum(us);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(int32_t &i) {
+        readNum(i);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(uint32_t &u) {
+        readNum(u);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(int64_t &l) {
+        readNum(l);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(uint64_t &ul) {
+        readNum(ul);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(float &f) {
+        readNum(f);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(double &d) {
+        readNum(d);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(std::string &s) {
+        std::string_view view;
+        if (((*this) >> view).fail() || view.empty())
+            return *this;
+        s.assign(view.data(), view.size());
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferIStream<Order> &BasicBufferIStream<Order>::operator>>(std::string_view &s) {
+        int size;
+        readNum(size);
+        if (fail() || size == 0)
+            return *this;
+
+        if (size < 0 || size_t(size) > remaining()) {
+            _state |= std::ios::failbit | std::ios::eofbit;
+            return *this;
+        }
+        s = std::string_view(_data + _pos, size_t(size));
+        _pos += size_t(size);
+        return *this;
+    }
+
+    // Writes the OStream format by appending to a string, which is grown geometrically
+    template <ByteOrder Order>
+    class BasicBufferOStream {
+    public:
+        inline explicit BasicBufferOStream(std::string *buffer);
+
+    public:
+        inline std::string *buffer() const;
+        inline size_t pos() const;
+
+        inline std::ios::iostate state() const;
+        inline void setState(std::ios::iostate state);
+
+        inline bool good() const;
+        inline bool fail() const;
+
+        inline int writeRawData(const char *data, int len);
+        inline int skipRawData(int len);
+        inline int align(int size);
+
+        template <class T>
+        inline bool writeNumbers(const T *data, size_t count);
+
+        inline BasicBufferOStream &operator<<(int8_t c);
+        inline BasicBufferOStream &operator<<(uint8_t uc);
+        inline BasicBufferOStream &operator<<(int16_t s);
+        inline BasicBufferOStream &operator<<(uint16_t us);
+        inline BasicBufferOStream &operator<<(int32_t i);
+        inline BasicBufferOStream &operator<<(uint32_t u);
+        inline BasicBufferOStream &operator<<(int64_t l);
+        inline BasicBufferOStream &operator<<(uint64_t ul);
+        inline BasicBufferOStream &operator<<(float f);
+        inline BasicBufferOStream &operator<<(double d);
+        inline BasicBufferOStream &operator<<(const std::string_view &s);
+        inline BasicBufferOStream &operator<<(const std::string &s);
+        inline BasicBufferOStream &operator<<(const char *s);
+
+    private:
+        template <class T>
+        inline void writeNum(T value);
+
+        std::string *_buffer;
+        std::ios::iostate _state;
+    };
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order>::BasicBufferOStream(std::string *buffer)
+        : _buffer(buffer), _state(std::ios::goodbit) {
+    }
+
+    template <ByteOrder Order>
+    inline std::string *BasicBufferOStream<Order>::buffer() const {
+        return _buffer;
+    }
+
+    template <ByteOrder Order>
+    inline size_t BasicBufferOStream<Order>::pos() const {
+        return _buffer->size();
+    }
+
+    template <ByteOrder Order>
+    inline std::ios::iostate BasicBufferOStream<Order>::state() const {
+        return _state;
+    }
+
+    template <ByteOrder Order>
+    inline void BasicBufferOStream<Order>::setState(std::ios::iostate state) {
+        _state |= state;
+    }
+
+    template <ByteOrder Order>
+    inline bool BasicBufferOStream<Order>::good() const {
+        return _state == std::ios::goodbit;
+    }
+
+    template <ByteOrder Order>
+    inline bool BasicBufferOStream<Order>::fail() const {
+        return (_state & (std::ios::failbit | std::ios::badbit)) != 0;
+    }
+
+    template <ByteOrder Order>
+    inline int BasicBufferOStream<Order>::writeRawData(const char *data, int len) {
+        if (fail() || len <= 0) {
+            return 0;
+        }
+        _buffer->append(data, size_t(len));
+        return len;
+    }
+
+    template <ByteOrder Order>
+    inline int BasicBufferOStream<Order>::skipRawData(int len) {
+        if (fail() || len <= 0) {
+            return 0;
+        }
+        _buffer->append(size_t(len), '\0');
+        return len;
+    }
+
+    template <ByteOrder Order>
+    inline int BasicBufferOStream<Order>::align(int size) {
+        auto rem = int(_buffer->size() % size);
+        if (rem == 0)
+            return 0;
+        return skipRawData(size - rem);
+    }
+
+    template <ByteOrder Order>
+    template <class T>
+    inline bool BasicBufferOStream<Order>::writeNumbers(const T *data, size_t count) {
+        static_assert(IsStreamNumber<T>::value);
+        if (fail()) {
+            return false;
+        }
+        size_t org = _buffer->size();
+        _buffer->resize(org + count * sizeof(T));
+        char *dst = _buffer->data() + org;
+        if constexpr (Order == MTC::HostByteOrder) {
+            memcpy(dst, data, count * sizeof(T));
+        } else {
+            // The buffer end is not aligned for T, swap through an aligned local buffer
+            T buf[512];
+            for (size_t i = 0; i < count; i += std::size(buf)) {
+                size_t n = std::min(count - i, std::size(buf));
+                std::copy_n(data + i, n, buf);
+                MTC::byteSwapArray(buf, n);
+                memcpy(dst + i * sizeof(T), buf, n * sizeof(T));
+            }
+        }
+        return true;
+    }
+
+    template <ByteOrder Order>
+    template <class T>
+    inline void BasicBufferOStream<Order>::writeNum(T value) {
+        if (fail()) {
+            return;
+        }
+        value = MTC::fromHostOrder<Order>(value);
+        _buffer->append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(int8_t c) {
+        writeNum(c);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(uint8_t uc) {
+        writeNum(uc);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(int16_t s) {
+        writeNum(s);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(uint16_t us) {
+        writeNum(us);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(int32_t i) {
+        writeNum(i);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(uint32_t u) {
+        writeNum(u);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(int64_t l) {
+        writeNum(l);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(uint64_t ul) {
+        writeNum(ul);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(float f) {
+        writeNum(f);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(double d) {
+        writeNum(d);
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &
+        BasicBufferOStream<Order>::operator<<(const std::string_view &s) {
+        writeNum(int(s.size()));
+        if (!fail()) {
+            _buffer->append(s.data(), s.size());
+        }
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(const std::string &s) {
+        return (*this) << std::string_view(s);
+    }
+
+    template <ByteOrder Order>
+    inline BasicBufferOStream<Order> &BasicBufferOStream<Order>::operator<<(const char *s) {
+        return (*this) << std::string_view(s);
+    }
+
+    template <ByteOrder Order>
+    struct IsInputStream<BasicBufferIStream<Order>> : std::true_type {};
+
+    template <ByteOrder Order>
+    struct IsOutputStream<BasicBufferOStream<Order>> : std::true_type {};
+
+    using BufferIStream = BasicBufferIStream<MTC::HostByteOrder>;
+    using BufferOStream = BasicBufferOStream<MTC::HostByteOrder>;
+
+    using LittleEndianBufferIStream = BasicBufferIStream<ByteOrder::LittleEndian>;
+    using LittleEndianBufferOStream = BasicBufferOStream<ByteOrder::LittleEndian>;
+    using BigEndianBufferIStream = BasicBufferIStream<ByteOrder::BigEndian>;
+    using BigEndianBufferOStream = BasicBufferOStream<ByteOrder::BigEndian>;
+
+}
+
+#endif // BUFFERSTREAM_H
@@ -0,0 +1,118 @@
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#  include <stdlib.h>
+#endif
+
+namespace MTC {
+
+    enum class ByteOrder {
+        LittleEndian,
+        BigEndian,
+    };
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr const ByteOrder HostByteOrder = ByteOrder::BigEndian;
+#else
+    static constexpr const ByteOrder HostByteOrder = ByteOrder::LittleEndian;
+#endif
+
+    inline uint8_t byteSwap(uint8_t value) {
+        return value;
+    }
+
+    inline uint16_t byteSwap(uint16_t value) {
+#ifdef _MSC_VER
+        return _byteswap_ushort(value);
+#else
+        return __builtin_bswap16(value);
+#endif
+    }
+
+    inline uint32_t byteSwap(uint32_t value) {
+#ifdef _MSC_VER
+        return _byteswap_ulong(value);
+#else
+        return __builtin_bswap32(value);
+#endif
+    }
+
+    inline uint64_t byteSwap(uint64_t value) {
+#ifdef _MSC_VER
+        return _byteswap_uint64(value);
+#else
+        return __builtin_bswap64(value);
+#endif
+    }
+
+    // Swaps any arithmetic or enum value through the unsigned integer of the same size
+    template <class T>
+    inline T byteSwapValue(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        if constexpr (sizeof(T) == 1) {
+            return value;
+        } else {
+            using U = std::conditional_t<
+                sizeof(T) == 2, uint16_t,
+                std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+            U bits;
+            memcpy(&bits, &value, sizeof(T));
+            bits = byteSwap(bits);
+            memcpy(&value, &bits, sizeof(T));
+            return value;
+        }
+    }
+
+    // Converts between the given order and the host order, a no-op when they match
+    template <ByteOrder Order, class T>
+    inline T toHostOrder(T value) {
+        if constexpr (Order == HostByteOrder) {
+            return value;
+        } else {
+            return byteSwapValue(value);
+        }
+    }
+
+    template <ByteOrder Order, class T>
+    inline T fromHostOrder(T value) {
+        return toHostOrder<Order>(value);
+    }
+
+    template <ByteOrder Order, class T>
+    inline T loadValue(const void *data) {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        return toHostOrder<Order>(value);
+    }
+
+    template <ByteOrder Order, class T>
+    inline void storeValue(void *data, T value) {
+        value = fromHostOrder<Order>(value);
+        memcpy(data, &value, sizeof(T));
+    }
+
+    // Swaps an array of numbers in place. The loop has no dependencies between elements, so
+    // optimizing compilers turn it into byte shuffles over whole vector registers.
+    template <class T>
+    inline void byteSwapArray(T *data, size_t count) {
+        static_assert(std::is_arithmetic_v<T>);
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = byteSwapValue(data[i]);
+        }
+    }
+
+    template <ByteOrder Order, class T>
+    inline void toHostOrderArray(T *data, size_t count) {
+        if constexpr (Order != HostByteOrder) {
+            byteSwapArray(data, count);
+        }
+    }
+
+}
+
+#endif // BYTEORDER_H
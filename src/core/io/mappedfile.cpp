@@ -0,0 +1,134 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace MTC {
+
+    class MappedFile::Impl {
+    public:
+        const char *data = nullptr;
+        size_t size = 0;
+        bool opened = false;
+
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+    MappedFile::MappedFile() : _impl(std::make_unique<Impl>()) {
+    }
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::filesystem::path &path) {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!::GetFileSizeEx(file, &fileSize)) {
+            ::CloseHandle(file);
+            return false;
+        }
+
+        // Empty files cannot be mapped, but are still valid to open
+        if (fileSize.QuadPart > 0) {
+            HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) {
+                ::CloseHandle(file);
+                return false;
+            }
+            auto view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!view) {
+                ::CloseHandle(mapping);
+                ::CloseHandle(file);
+                return false;
+            }
+            _impl->mapping = mapping;
+            _impl->data = static_cast<const char *>(view);
+        }
+        _impl->file = file;
+        _impl->size = size_t(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        // Empty files cannot be mapped, but are still valid to open
+        if (st.st_size > 0) {
+            auto addr = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            _impl->data = static_cast<const char *>(addr);
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+        _impl->size = size_t(st.st_size);
+#endif
+        _impl->opened = true;
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (!_impl->opened) {
+            return;
+        }
+
+#ifdef _WIN32
+        if (_impl->data) {
+            ::UnmapViewOfFile(_impl->data);
+        }
+        if (_impl->mapping) {
+            ::CloseHandle(_impl->mapping);
+            _impl->mapping = nullptr;
+        }
+        ::CloseHandle(_impl->file);
+        _impl->file = INVALID_HANDLE_VALUE;
+#else
+        if (_impl->data) {
+            ::munmap(const_cast<char *>(_impl->data), _impl->size);
+        }
+#endif
+        _impl->data = nullptr;
+        _impl->size = 0;
+        _impl->opened = false;
+    }
+
+    bool MappedFile::isOpen() const {
+        return _impl->opened;
+    }
+
+    const char *MappedFile::data() const {
+        return _impl->data;
+    }
+
+    size_t MappedFile::size() const {
+        return _impl->size;
+    }
+
+}
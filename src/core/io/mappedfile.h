@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <memory>
+#include <filesystem>
+
+#include <mtccore/mtccoreglobal.h>
+
+namespace MTC {
+
+    class MTC_CORE_EXPORT MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+    public:
+        bool open(const std::filesystem::path &path);
+        void close();
+
+        bool isOpen() const;
+
+        const char *data() const;
+        size_t size() const;
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,186 @@
+#include "randomaccessfile.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#  define MTC_HAS_PREADV
+#endif
+
+namespace MTC {
+
+    class RandomAccessFile::Impl {
+    public:
+        uint64_t size = 0;
+
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+#else
+        int fd = -1;
+#endif
+    };
+
+    RandomAccessFile::RandomAccessFile() : _impl(std::make_unique<Impl>()) {
+    }
+
+    RandomAccessFile::~RandomAccessFile() {
+        close();
+    }
+
+    bool RandomAccessFile::open(const std::filesystem::path &path) {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!::GetFileSizeEx(file, &fileSize)) {
+            ::CloseHandle(file);
+            return false;
+        }
+        _impl->file = file;
+        _impl->size = uint64_t(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        _impl->fd = fd;
+        _impl->size = uint64_t(st.st_size);
+#endif
+        return true;
+    }
+
+    void RandomAccessFile::close() {
+#ifdef _WIN32
+        if (_impl->file != INVALID_HANDLE_VALUE) {
+            ::CloseHandle(_impl->file);
+            _impl->file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (_impl->fd >= 0) {
+            ::close(_impl->fd);
+            _impl->fd = -1;
+        }
+#endif
+        _impl->size = 0;
+    }
+
+    bool RandomAccessFile::isOpen() const {
+#ifdef _WIN32
+        return _impl->file != INVALID_HANDLE_VALUE;
+#else
+        return _impl->fd >= 0;
+#endif
+    }
+
+    uint64_t RandomAccessFile::size() const {
+        return _impl->size;
+    }
+
+    size_t RandomAccessFile::read(uint64_t offset, char *data, size_t size) const {
+        size_t total = 0;
+        while (total < size) {
+#ifdef _WIN32
+            OVERLAPPED overlapped{};
+            uint64_t pos = offset + total;
+            overlapped.Offset = DWORD(pos & 0xFFFFFFFF);
+            overlapped.OffsetHigh = DWORD(pos >> 32);
+
+            DWORD chunk = DWORD(std::min<size_t>(size - total, 0x40000000));
+            DWORD bytesRead = 0;
+            if (!::ReadFile(_impl->file, data + total, chunk, &bytesRead, &overlapped) ||
+                bytesRead == 0) {
+                break;
+            }
+#else
+            auto bytesRead = ::pread(_impl->fd, data + total, size - total, off_t(offset + total));
+            if (bytesRead < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (bytesRead == 0) {
+                break;
+            }
+#endif
+            total += size_t(bytesRead);
+        }
+        return total;
+    }
+
+    size_t RandomAccessFile::readv(uint64_t offset, const Segment *segments,
+                                   size_t count) const {
+#ifdef MTC_HAS_PREADV
+        std::vector<iovec> iov(count);
+        for (size_t i = 0; i < count; ++i) {
+            iov[i].iov_base = segments[i].data;
+            iov[i].iov_len = segments[i].size;
+        }
+
+        static const int maxCount =
+            int(std::max<long>(1, std::min<long>(::sysconf(_SC_IOV_MAX), 1024)));
+
+        size_t total = 0;
+        size_t index = 0;
+        while (index < count) {
+            int n = int(std::min<size_t>(count - index, maxCount));
+            auto bytesRead = ::preadv(_impl->fd, &iov[index], n, off_t(offset + total));
+            if (bytesRead < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (bytesRead == 0) {
+                break;
+            }
+            total += size_t(bytesRead);
+
+            // Skip the filled buffers and trim a partially filled one
+            size_t remaining = size_t(bytesRead);
+            while (index < count && remaining >= iov[index].iov_len) {
+                remaining -= iov[index].iov_len;
+                ++index;
+            }
+            if (remaining > 0) {
+                iov[index].iov_base = static_cast<char *>(iov[index].iov_base) + remaining;
+                iov[index].iov_len -= remaining;
+            }
+        }
+        return total;
+#else
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto bytesRead = read(offset + total, segments[i].data, segments[i].size);
+            total += bytesRead;
+            if (bytesRead != segments[i].size) {
+                break;
+            }
+        }
+        return total;
+#endif
+    }
+
+}
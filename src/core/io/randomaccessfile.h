@@ -0,0 +1,45 @@
+#ifndef RANDOMACCESSFILE_H
+#define RANDOMACCESSFILE_H
+
+#include <memory>
+#include <filesystem>
+
+#include <mtccore/mtccoreglobal.h>
+
+namespace MTC {
+
+    // Read-only file with positional reads, safe to share between threads since no read
+    // depends on a file cursor.
+    class MTC_CORE_EXPORT RandomAccessFile {
+    public:
+        RandomAccessFile();
+        ~RandomAccessFile();
+
+        RandomAccessFile(const RandomAccessFile &) = delete;
+        RandomAccessFile &operator=(const RandomAccessFile &) = delete;
+
+        struct Segment {
+            char *data;
+            size_t size;
+        };
+
+    public:
+        bool open(const std::filesystem::path &path);
+        void close();
+
+        bool isOpen() const;
+        uint64_t size() const;
+
+        size_t read(uint64_t offset, char *data, size_t size) const;
+
+        // Reads consecutive file bytes into several buffers with a single request if possible
+        size_t readv(uint64_t offset, const Segment *segments, size_t count) const;
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // RANDOMACCESSFILE_H
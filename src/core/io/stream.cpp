@@ -1,210 +1,275 @@
-#include "stream.h"
-
-#include <cstdint>
-
-namespace Substate {
-
-    template <class T>
-    static bool substate_readNum(std::istream &in, T &i) {
-        i = 0;
-        if (in.read(reinterpret_cast<char *>(&i), sizeof(T)).fail()) {
-            i = 0;
-            return false;
-        }
-        return true;
-    }
-
-    template <class T>
-    static bool substate_writeNum(std::ostream &out, T i) {
-        if (out.write(reinterpret_cast<const char *>(&i), sizeof(T)).fail()) {
-            return false;
-        }
-        return true;
-    }
-
-    IStream::IStream(std::istream *in) : in(in) {
-    }
-    IStream::~IStream() {
-    }
-    int IStream::readRawData(char *data, int len) {
-        auto org = in->tellg();
-        in->read(data, len);
-        return int(in->tellg() - org);
-    }
-    int IStream::skipRawData(int len) {
-        auto org = in->tellg();
-        in->ignore(len);
-        return int(in->tellg() - org);
-    }
-    int IStream::align(int size) {
-        auto rem = int(in->tellg() % size);
-        if (rem == 0)
-            return 0;
-        return skipRawData(size - rem);
-    }
-    IStream &IStream::operator>>(bool &b) {
-        int8_t c;
-        (*this) >> c;
-        b = in->good() && c;
-        return *this;
-    }
-    IStream &IStream::operator>>(int8_t &c) {
-        substate_readNum(*in, c);
-        return *this;
-    }
-    IStream &IStream::operator>>(uint8_t &uc) {
-        substate_readNum(*in, uc);
-        return *this;
-    }
-    IStream &IStream::operator>>(int16_t &s) {
-        substate_readNum(*in, s);
-        return *this;
-    }
-    IStream &IStream::operator>>(uint16_t &us) {
-        substate_readNum(*in, us);
-        return *this;
-    }
-    IStream &IStream::operator>>(int32_t &i) {
-        substate_readNum(*in, i);
-        return *this;
-    }
-    IStream &IStream::operator>>(uint32_t &u) {
-        substate_readNum(*in, u);
-        return *this;
-    }
-    IStream &IStream::operator>>(int64_t &l) {
-        substate_readNum(*in, l);
-        return *this;
-    }
-    IStream &IStream::operator>>(uint64_t &ul) {
-        substate_readNum(*in, ul);
-        return *this;
-    }
-    IStream &IStream::operator>>(float &f) {
-        substate_readNum(*in, f);
-        return *this;
-    }
-    IStream &IStream::operator>>(double &d) {
-        substate_readNum(*in, d);
-        return *this;
-    }
-    IStream &IStream::operator>>(std::string &s) {
-        int size;
-
-        // Read size
-        (*this) >> size;
-        if (in->fail() || size == 0)
-            return *this;
-
-        // Read string
-        auto buf = new char[size];
-        in->read(buf, size);
-        if (in->good()) {
-            s = std::string(buf, size);
-        }
-        delete[] buf;
-
-        return *this;
-    }
-
-    OStream::OStream(std::ostream *out) : out(out) {
-    }
-    OStream::~OStream() {
-    }
-    int OStream::writeRawData(const char *data, int len) {
-        auto org = out->tellp();
-        out->write(data, len);
-        return int(out->tellp() - org);
-    }
-    int OStream::skipRawData(int len) {
-        // for (int i = 0; i < len; ++i) {
-        //     out->put('\0');
-        //     if (out->fail())
-        //         return i;
-        // }
-        // return len;
-
-        if (len <= 0) {
-            return 0;
-        }
-
-        static const constexpr std::size_t blockSize = 8;
-        static const constexpr char buffer[blockSize] = {};
-
-        std::size_t fullBlocks = len / blockSize;
-        std::size_t lastBlockSize = len % blockSize;
-
-        auto org = out->tellp();
-
-        for (std::size_t i = 0; i < fullBlocks; ++i) {
-            out->write(buffer, blockSize);
-        }
-
-        if (lastBlockSize > 0) {
-            out->write(buffer, std::streamsize(lastBlockSize));
-        }
-        return int(out->tellp() - org);
-    }
-    int OStream::align(int size) {
-        auto rem = int(out->tellp() % size);
-        if (rem == 0)
-            return 0;
-        return skipRawData(size - rem);
-    }
-    OStream &OStream::operator<<(int8_t c) {
-        substate_writeNum(*out, c);
-        return *this;
-    }
-    OStream &OStream::operator<<(uint8_t uc) {
-        substate_writeNum(*out, uc);
-        return *this;
-    }
-    OStream &OStream::operator<<(int16_t s) {
-        substate_writeNum(*out, s);
-        return *this;
-    }
-    OStream &OStream::operator<<(uint16_t us) {
-        substate_writeNum(*out, us);
-        return *this;
-    }
-    OStream &OStream::operator<<(int32_t i) {
-        substate_writeNum(*out, i);
-        return *this;
-    }
-    OStream &OStream::operator<<(uint32_t u) {
-        substate_writeNum(*out, u);
-        return *this;
-    }
-    OStream &OStream::operator<<(int64_t l) {
-        substate_writeNum(*out, l);
-        return *this;
-    }
-    OStream &OStream::operator<<(uint64_t ul) {
-        substate_writeNum(*out, ul);
-        return *this;
-    }
-    OStream &OStream::operator<<(float f) {
-        substate_writeNum(*out, f);
-        return *this;
-    }
-    OStream &OStream::operator<<(double d) {
-        substate_writeNum(*out, d);
-        return *this;
-    }
-    OStream &OStream::operator<<(const std::string_view &s) {
-        // Write size
-        (*this) << int(s.size());
-
-        // Write string
-        out->write(s.data(), std::streamsize(s.size()));
-        return *this;
-    }
-    OStream &OStream::operator<<(const std::string &s) {
-        return (*this) << std::string_view(s);
-    }
-
-    OStream &OStream::operator<<(const char *s) {
-        return (*this) << std::string_view(s);
-    }
-
-}
\ No newline at end of file
+#include "stream.h"
+
+#include <cstdint>
+#include <algorithm>
+
+namespace Substate {
+
+    template <ByteOrder Order, class T>
+    static bool substate_readNum(std::istream &in, T &i) {
+        i = 0;
+        if (in.read(reinterpret_cast<char *>(&i), sizeof(T)).fail()) {
+            i = 0;
+            return false;
+        }
+        i = MTC::toHostOrder<Order>(i);
+        return true;
+    }
+
+    template <ByteOrder Order, class T>
+    static bool substate_writeNum(std::ostream &out, T i) {
+        i = MTC::fromHostOrder<Order>(i);
+        if (out.write(reinterpret_cast<const char *>(&i), sizeof(T)).fail()) {
+            return false;
+        }
+        return true;
+    }
+
+    template <ByteOrder Order>
+    BasicIStream<Order>::BasicIStream(std::istream *in) : in(in) {
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order>::~BasicIStream() {
+    }
+    template <ByteOrder Order>
+    int BasicIStream<Order>::readRawData(char *data, int len) {
+        auto org = in->tellg();
+        in->read(data, len);
+        return int(in->tellg() - org);
+    }
+    template <ByteOrder Order>
+    int BasicIStream<Order>::skipRawData(int len) {
+        auto org = in->tellg();
+        in->ignore(len);
+        return int(in->tellg() - org);
+    }
+    template <ByteOrder Order>
+    int BasicIStream<Order>::align(int size) {
+        auto rem = int(in->tellg() % size);
+        if (rem == 0)
+            return 0;
+        return skipRawData(size - rem);
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(bool &b) {
+        int8_t c;
+        (*this) >> c;
+        b = in->good() && c;
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(int8_t &c) {
+        substate_readNum<Order>(*in, c);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(uint8_t &uc) {
+        substate_readNum<Order>(*in, uc);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(int16_t &s) {
+        substate_readNum<Order>(*in, s);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(uint16_t &us) {
+        substate_readNum<Order>(*in, us);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(int32_t &i) {
+        substate_readNum<Order>(*in, i);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(uint32_t &u) {
+        substate_readNum<Order>(*in, u);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(int64_t &l) {
+        substate_readNum<Order>(*in, l);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(uint64_t &ul) {
+        substate_readNum<Order>(*in, ul);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(float &f) {
+        substate_readNum<Order>(*in, f);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(double &d) {
+        substate_readNum<Order>(*in, d);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicIStream<Order> &BasicIStream<Order>::operator>>(std::string &s) {
+        int size;
+
+        // Read size
+        (*this) >> size;
+        if (in->fail() || size == 0)
+            return *this;
+
+        if (size < 0) {
+            in->setstate(std::ios::failbit);
+            return *this;
+        }
+
+        // A seekable device tells how much is left, so a corrupt size fails before allocating.
+        // Otherwise the string grows in bounded steps and a short read stops it early.
+        size_t step = 1 << 20;
+        auto org = in->tellg();
+        if (org != std::istream::pos_type(-1)) {
+            in->seekg(0, std::ios::end);
+            auto end = in->tellg();
+            in->seekg(org);
+            if (end - org < size) {
+                in->setstate(std::ios::failbit | std::ios::eofbit);
+                return *this;
+            }
+            step = size_t(size);
+        }
+
+        // Read string
+        s.clear();
+        for (size_t pos = 0; pos < size_t(size); pos += step) {
+            size_t n = std::min(step, size_t(size) - pos);
+            s.resize(pos + n);
+            if (in->read(s.data() + pos, std::streamsize(n)).fail()) {
+                s.clear();
+                break;
+            }
+        }
+        return *this;
+    }
+
+    template <ByteOrder Order>
+    BasicOStream<Order>::BasicOStream(std::ostream *out) : out(out) {
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order>::~BasicOStream() {
+    }
+    template <ByteOrder Order>
+    int BasicOStream<Order>::writeRawData(const char *data, int len) {
+        auto org = out->tellp();
+        out->write(data, len);
+        return int(out->tellp() - org);
+    }
+    template <ByteOrder Order>
+    int BasicOStream<Order>::skipRawData(int len) {
+        // for (int i = 0; i < len; ++i) {
+        //     out->put('\0');
+        //     if (out->fail())
+        //         return i;
+        // }
+        // return len;
+
+        if (len <= 0) {
+            return 0;
+        }
+
+        static const constexpr std::size_t blockSize = 8;
+        static const constexpr char buffer[blockSize] = {};
+
+        std::size_t fullBlocks = len / blockSize;
+        std::size_t lastBlockSize = len % blockSize;
+
+        auto org = out->tellp();
+
+        for (std::size_t i = 0; i < fullBlocks; ++i) {
+            out->write(buffer, blockSize);
+        }
+
+        if (lastBlockSize > 0) {
+            out->write(buffer, std::streamsize(lastBlockSize));
+        }
+        return int(out->tellp() - org);
+    }
+    template <ByteOrder Order>
+    int BasicOStream<Order>::align(int size) {
+        auto rem = int(out->tellp() % size);
+        if (rem == 0)
+            return 0;
+        return skipRawData(size - rem);
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(int8_t c) {
+        substate_writeNum<Order>(*out, c);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(uint8_t uc) {
+        substate_writeNum<Order>(*out, uc);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(int16_t s) {
+        substate_writeNum<Order>(*out, s);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(uint16_t us) {
+        substate_writeNum<Order>(*out, us);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(int32_t i) {
+        substate_writeNum<Order>(*out, i);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(uint32_t u) {
+        substate_writeNum<Order>(*out, u);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(int64_t l) {
+        substate_writeNum<Order>(*out, l);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(uint64_t ul) {
+        substate_writeNum<Order>(*out, ul);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(float f) {
+        substate_writeNum<Order>(*out, f);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(double d) {
+        substate_writeNum<Order>(*out, d);
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(const std::string_view &s) {
+        // Write size
+        (*this) << int(s.size());
+
+        // Write string
+        out->write(s.data(), std::streamsize(s.size()));
+        return *this;
+    }
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(const std::string &s) {
+        return (*this) << std::string_view(s);
+    }
+
+    template <ByteOrder Order>
+    BasicOStream<Order> &BasicOStream<Order>::operator<<(const char *s) {
+        return (*this) << std::string_view(s);
+    }
+
+    template class MTC_CORE_EXPORT BasicIStream<ByteOrder::LittleEndian>;
+    template class MTC_CORE_EXPORT BasicIStream<ByteOrder::BigEndian>;
+    template class MTC_CORE_EXPORT BasicOStream<ByteOrder::LittleEndian>;
+    template class MTC_CORE_EXPORT BasicOStream<ByteOrder::BigEndian>;
+
+}
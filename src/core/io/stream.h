@@ -1,256 +1,380 @@
-#ifndef STREAM_H
-#define STREAM_H
-
-#include <map>
-#include <set>
-#include <list>
-#include <vector>
-#include <unordered_map>
-#include <iostream>
-#include <string>
-
-#include <mtccore/mtccoreglobal.h>
-
-namespace Substate {
-
-    class MTC_CORE_EXPORT IStream {
-    public:
-        explicit IStream(std::istream *in);
-        ~IStream();
-
-    public:
-        inline std::istream *device() const;
-        inline std::ios::iostate state() const;
-        inline void setState(std::ios::iostate state);
-
-        inline bool good() const;
-        inline bool fail() const;
-
-        int readRawData(char *data, int len);
-        int skipRawData(int len);
-        int align(int size);
-
-        IStream &operator>>(bool &b);
-        IStream &operator>>(int8_t &c);
-        IStream &operator>>(uint8_t &uc);
-        IStream &operator>>(int16_t &s);
-        IStream &operator>>(uint16_t &us);
-        IStream &operator>>(int32_t &i);
-        IStream &operator>>(uint32_t &u);
-        IStream &operator>>(int64_t &l);
-        IStream &operator>>(uint64_t &ul);
-        IStream &operator>>(float &f);
-        IStream &operator>>(double &d);
-        IStream &operator>>(std::string &s);
-
-    private:
-        std::istream *in;
-    };
-
-    inline std::istream *IStream::device() const {
-        return in;
-    }
-
-    inline std::ios::iostate IStream::state() const {
-        return in->rdstate();
-    }
-
-    inline void IStream::setState(std::ios::iostate state) {
-        in->setstate(state);
-    }
-
-    bool IStream::good() const {
-        return in->good();
-    }
-
-    bool IStream::fail() const {
-        return in->fail();
-    }
-
-    class MTC_CORE_EXPORT OStream {
-    public:
-        explicit OStream(std::ostream *out);
-        ~OStream();
-
-    public:
-        inline std::ostream *device() const;
-        inline std::ios::iostate state() const;
-        inline void setState(std::ios::iostate state);
-
-        inline bool good() const;
-        inline bool fail() const;
-
-        int writeRawData(const char *data, int len);
-        int skipRawData(int len);
-        int align(int size);
-
-        OStream &operator<<(int8_t c);
-        OStream &operator<<(uint8_t uc);
-        OStream &operator<<(int16_t s);
-        OStream &operator<<(uint16_t us);
-        OStream &operator<<(int32_t i);
-        OStream &operator<<(uint32_t u);
-        OStream &operator<<(int64_t l);
-        OStream &operator<<(uint64_t ul);
-        OStream &operator<<(float f);
-        OStream &operator<<(double d);
-        OStream &operator<<(const std::string_view &s);
-        OStream &operator<<(const std::string &s);
-        OStream &operator<<(const char *s);
-
-    private:
-        std::ostream *out;
-    };
-
-    inline std::ostream *OStream::device() const {
-        return out;
-    }
-
-    inline std::ios::iostate OStream::state() const {
-        return out->rdstate();
-    }
-
-    inline void OStream::setState(std::ios::iostate state) {
-        out->setstate(state);
-    }
-
-    bool OStream::good() const {
-        return out->good();
-    }
-
-    bool OStream::fail() const {
-        return out->fail();
-    }
-
-    template <class Container>
-    IStream &readArrayBasedContainer(IStream &s, Container &c) {
-        c.clear();
-        int n;
-        s >> n;
-        c.reserve(n);
-        for (int i = 0; i < n; ++i) {
-            typename Container::value_type t;
-            s >> t;
-            if (s.fail()) {
-                c.clear();
-                break;
-            }
-            c.push_back(t);
-        }
-        return s;
-    }
-
-    template <class Container>
-    IStream &readAssociativeContainer(IStream &s, Container &c) {
-        c.clear();
-        int n;
-        s >> n;
-        for (int i = 0; i < n; ++i) {
-            typename Container::key_type k;
-            typename Container::mapped_type t;
-            s >> k >> t;
-            if (s.fail()) {
-                c.clear();
-                break;
-            }
-            c.insert(std::make_pair(k, t));
-        }
-        return s;
-    }
-
-    template <class Container>
-    OStream &writeSequentialContainer(OStream &s, const Container &c) {
-        s << int(c.size());
-        for (const auto &t : c)
-            s << t;
-        return s;
-    }
-
-    template <class Container>
-    OStream &writeAssociativeContainer(OStream &s, const Container &c) {
-        s << int(c.size());
-        for (const auto &p : c) {
-            s << p.first << p.second;
-            if (s.fail())
-                break;
-        }
-        return s;
-    }
-
-    template <class T>
-    inline IStream &operator>>(IStream &s, std::list<T> &l) {
-        return readArrayBasedContainer(s, l);
-    }
-
-    template <typename T>
-    inline OStream &operator<<(OStream &s, const std::list<T> &l) {
-        return writeSequentialContainer(s, l);
-    }
-
-    template <typename T>
-    inline IStream &operator>>(IStream &s, std::vector<T> &v) {
-        return readArrayBasedContainer(s, v);
-    }
-
-    template <typename T>
-    inline OStream &operator<<(OStream &s, const std::vector<T> &v) {
-        return writeSequentialContainer(s, v);
-    }
-
-    template <typename T>
-    inline IStream &operator>>(IStream &s, std::set<T> &set) {
-        set.clear();
-        int n;
-        s >> n;
-        for (int i = 0; i < n; ++i) {
-            T t;
-            s >> t;
-            if (s.fail()) {
-                set.clear();
-                break;
-            }
-            set.insert(t);
-        }
-        return s;
-    }
-
-    template <typename T>
-    inline OStream &operator<<(OStream &s, const std::set<T> &set) {
-        return writeSequentialContainer(s, set);
-    }
-
-    template <class Key, class T>
-    inline IStream &operator>>(IStream &s, std::unordered_map<Key, T> &hash) {
-        return readAssociativeContainer(s, hash);
-    }
-
-    template <class Key, class T>
-    inline OStream &operator<<(OStream &s, const std::unordered_map<Key, T> &hash) {
-        return writeAssociativeContainer(s, hash);
-    }
-
-    template <class Key, class T>
-    inline IStream &operator>>(IStream &s, std::map<Key, T> &map) {
-        return readAssociativeContainer(s, map);
-    }
-
-    template <class Key, class T>
-    inline OStream &operator<<(OStream &s, const std::map<Key, T> &map) {
-        return writeAssociativeContainer(s, map);
-    }
-
-    template <class T1, class T2>
-    inline IStream &operator>>(IStream &s, std::pair<T1, T2> &p) {
-        s >> p.first >> p.second;
-        return s;
-    }
-
-    template <class T1, class T2>
-    inline OStream &operator<<(OStream &s, const std::pair<T1, T2> &p) {
-        s << p.first << p.second;
-        return s;
-    }
-
-}
-
-#endif // STREAM_H
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+
+#include <mtccore/mtccoreglobal.h>
+#include <mtccore/byteorder.h>
+
+namespace Substate {
+
+    using MTC::ByteOrder;
+
+    // Types with a fixed-size operator>> and operator<<, arrays of them are transferred in bulk
+    template <class T>
+    struct IsStreamNumber
+        : std::bool_constant<
+              std::is_same_v<T, int8_t> || std::is_same_v<T, uint8_t> ||
+              std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t> ||
+              std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+              std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> ||
+              std::is_same_v<T, float> || std::is_same_v<T, double>> {};
+
+    // Stream classes the container operators below apply to
+    template <class Stream>
+    struct IsInputStream : std::false_type {};
+
+    template <class Stream>
+    struct IsOutputStream : std::false_type {};
+
+    // Numbers are stored in the byte order given as template argument, conversion is free when
+    // it matches the host
+    template <ByteOrder Order>
+    class BasicIStream {
+    public:
+        explicit BasicIStream(std::istream *in);
+        ~BasicIStream();
+
+    public:
+        inline std::istream *device() const;
+        inline std::ios::iostate state() const;
+        inline void setState(std::ios::iostate state);
+
+        inline bool good() const;
+        inline bool fail() const;
+
+        int readRawData(char *data, int len);
+        int skipRawData(int len);
+        int align(int size);
+
+        // Same result as reading each element with operator>>, in a single device read
+        template <class T>
+        bool readNumbers(T *data, size_t count);
+
+        BasicIStream &operator>>(bool &b);
+        BasicIStream &operator>>(int8_t &c);
+        BasicIStream &operator>>(uint8_t &uc);
+        BasicIStream &operator>>(int16_t &s);
+        BasicIStream &operator>>(uint16_t &us);
+        BasicIStream &operator>>(int32_t &i);
+        BasicIStream &operator>>(uint32_t &u);
+        BasicIStream &operator>>(int64_t &l);
+        BasicIStream &operator>>(uint64_t &ul);
+        BasicIStream &operator>>(float &f);
+        BasicIStream &operator>>(double &d);
+        BasicIStream &operator>>(std::string &s);
+
+    private:
+        std::istream *in;
+    };
+
+    template <ByteOrder Order>
+    inline std::istream *BasicIStream<Order>::device() const {
+        return in;
+    }
+
+    template <ByteOrder Order>
+    inline std::ios::iostate BasicIStream<Order>::state() const {
+        return in->rdstate();
+    }
+
+    template <ByteOrder Order>
+    inline void BasicIStream<Order>::setState(std::ios::iostate state) {
+        in->setstate(state);
+    }
+
+    template <ByteOrder Order>
+    bool BasicIStream<Order>::good() const {
+        return in->good();
+    }
+
+    template <ByteOrder Order>
+    bool BasicIStream<Order>::fail() const {
+        return in->fail();
+    }
+
+    template <ByteOrder Order>
+    template <class T>
+    bool BasicIStream<Order>::readNumbers(T *data, size_t count) {
+        static_assert(IsStreamNumber<T>::value);
+        if (in->read(reinterpret_cast<char *>(data), std::streamsize(count * sizeof(T))).fail()) {
+            return false;
+        }
+        MTC::toHostOrderArray<Order>(data, count);
+        return true;
+    }
+
+    template <ByteOrder Order>
+    class BasicOStream {
+    public:
+        explicit BasicOStream(std::ostream *out);
+        ~BasicOStream();
+
+    public:
+        inline std::ostream *device() const;
+        inline std::ios::iostate state() const;
+        inline void setState(std::ios::iostate state);
+
+        inline bool good() const;
+        inline bool fail() const;
+
+        int writeRawData(const char *data, int len);
+        int skipRawData(int len);
+        int align(int size);
+
+        template <class T>
+        bool writeNumbers(const T *data, size_t count);
+
+        BasicOStream &operator<<(int8_t c);
+        BasicOStream &operator<<(uint8_t uc);
+        BasicOStream &operator<<(int16_t s);
+        BasicOStream &operator<<(uint16_t us);
+        BasicOStream &operator<<(int32_t i);
+        BasicOStream &operator<<(uint32_t u);
+        BasicOStream &operator<<(int64_t l);
+        BasicOStream &operator<<(uint64_t ul);
+        BasicOStream &operator<<(float f);
+        BasicOStream &operator<<(double d);
+        BasicOStream &operator<<(const std::string_view &s);
+        BasicOStream &operator<<(const std::string &s);
+        BasicOStream &operator<<(const char *s);
+
+    private:
+        std::ostream *out;
+    };
+
+    template <ByteOrder Order>
+    inline std::ostream *BasicOStream<Order>::device() const {
+        return out;
+    }
+
+    template <ByteOrder Order>
+    inline std::ios::iostate BasicOStream<Order>::state() const {
+        return out->rdstate();
+    }
+
+    template <ByteOrder Order>
+    inline void BasicOStream<Order>::setState(std::ios::iostate state) {
+        out->setstate(state);
+    }
+
+    template <ByteOrder Order>
+    bool BasicOStream<Order>::good() const {
+        return out->good();
+    }
+
+    template <ByteOrder Order>
+    bool BasicOStream<Order>::fail() const {
+        return out->fail();
+    }
+
+    template <ByteOrder Order>
+    template <class T>
+    bool BasicOStream<Order>::writeNumbers(const T *data, size_t count) {
+        static_assert(IsStreamNumber<T>::value);
+        if constexpr (Order == MTC::HostByteOrder) {
+            out->write(reinterpret_cast<const char *>(data), std::streamsize(count * sizeof(T)));
+        } else {
+            T buf[512];
+            for (size_t i = 0; i < count; i += std::size(buf)) {
+                size_t n = std::min(count - i, std::size(buf));
+                std::copy_n(data + i, n, buf);
+                MTC::byteSwapArray(buf, n);
+                out->write(reinterpret_cast<const char *>(buf), std::streamsize(n * sizeof(T)));
+            }
+        }
+        return !out->fail();
+    }
+
+    template <ByteOrder Order>
+    struct IsInputStream<BasicIStream<Order>> : std::true_type {};
+
+    template <ByteOrder Order>
+    struct IsOutputStream<BasicOStream<Order>> : std::true_type {};
+
+    // Defined in stream.cpp for both byte orders
+    extern template class MTC_CORE_EXPORT BasicIStream<ByteOrder::LittleEndian>;
+    extern template class MTC_CORE_EXPORT BasicIStream<ByteOrder::BigEndian>;
+    extern template class MTC_CORE_EXPORT BasicOStream<ByteOrder::LittleEndian>;
+    extern template class MTC_CORE_EXPORT BasicOStream<ByteOrder::BigEndian>;
+
+    // Host order, the format written by earlier versions
+    using IStream = BasicIStream<MTC::HostByteOrder>;
+    using OStream = BasicOStream<MTC::HostByteOrder>;
+
+    using LittleEndianIStream = BasicIStream<ByteOrder::LittleEndian>;
+    using LittleEndianOStream = BasicOStream<ByteOrder::LittleEndian>;
+    using BigEndianIStream = BasicIStream<ByteOrder::BigEndian>;
+    using BigEndianOStream = BasicOStream<ByteOrder::BigEndian>;
+
+    template <class Stream, class Container>
+    Stream &readArrayBasedContainer(Stream &s, Container &c) {
+        c.clear();
+        int n;
+        s >> n;
+
+        using T = typename Container::value_type;
+        if constexpr (std::is_same_v<Container, std::vector<T>> && IsStreamNumber<T>::value) {
+            // The count is untrusted, grow in bounded steps so that a corrupt one fails on a
+            // short read before allocating the whole array
+            size_t step = (size_t(1) << 20) / sizeof(T);
+            for (size_t pos = 0; n > 0 && pos < size_t(n); pos += step) {
+                size_t count = std::min(step, size_t(n) - pos);
+                c.resize(pos + count);
+                if (!s.readNumbers(c.data() + pos, count)) {
+                    c.clear();
+                    break;
+                }
+            }
+            return s;
+        }
+
+        c.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            T t;
+            s >> t;
+            if (s.fail()) {
+                c.clear();
+                break;
+            }
+            c.push_back(t);
+        }
+        return s;
+    }
+
+    template <class Stream, class Container>
+    Stream &readAssociativeContainer(Stream &s, Container &c) {
+        c.clear();
+        int n;
+        s >> n;
+        for (int i = 0; i < n; ++i) {
+            typename Container::key_type k;
+            typename Container::mapped_type t;
+            s >> k >> t;
+            if (s.fail()) {
+                c.clear();
+                break;
+            }
+            c.insert(std::make_pair(k, t));
+        }
+        return s;
+    }
+
+    template <class Stream, class Container>
+    Stream &writeSequentialContainer(Stream &s, const Container &c) {
+        s << int(c.size());
+
+        using T = typename Container::value_type;
+        if constexpr (std::is_same_v<Container, std::vector<T>> && IsStreamNumber<T>::value) {
+            s.writeNumbers(c.data(), c.size());
+            return s;
+        }
+
+        for (const auto &t : c)
+            s << t;
+        return s;
+    }
+
+    template <class Stream, class Container>
+    Stream &writeAssociativeContainer(Stream &s, const Container &c) {
+        s << int(c.size());
+        for (const auto &p : c) {
+            s << p.first << p.second;
+            if (s.fail())
+                break;
+        }
+        return s;
+    }
+
+    template <class Stream>
+    using IfInputStream = std::enable_if_t<IsInputStream<Stream>::value, int>;
+
+    template <class Stream>
+    using IfOutputStream = std::enable_if_t<IsOutputStream<Stream>::value, int>;
+
+    template <class Stream, typename T, IfInputStream<Stream> = 0>
+    inline Stream &operator>>(Stream &s, std::list<T> &l) {
+        return readArrayBasedContainer(s, l);
+    }
+
+    template <class Stream, typename T, IfOutputStream<Stream> = 0>
+    inline Stream &operator<<(Stream &s, const std::list<T> &l) {
+        return writeSequentialContainer(s, l);
+    }
+
+    template <class Stream, typename T, IfInputStream<Stream> = 0>
+    inline Stream &operator>>(Stream &s, std::vector<T> &v) {
+        return readArrayBasedContainer(s, v);
+    }
+
+    template <class Stream, typename T, IfOutputStream<Stream> = 0>
+    inline Stream &operator<<(Stream &s, const std::vector<T> &v) {
+        return writeSequentialContainer(s, v);
+    }
+
+    template <class Stream, typename T, IfInputStream<Stream> = 0>
+    inline Stream &operator>>(Stream &s, std::set<T> &set) {
+        set.clear();
+        int n;
+        s >> n;
+        for (int i = 0; i < n; ++i) {
+            T t;
+            s >> t;
+            if (s.fail()) {
+                set.clear();
+                break;
+            }
+            set.insert(t);
+        }
+        return s;
+    }
+
+    template <class Stream, typename T, IfOutputStream<Stream> = 0>
+    inline Stream &operator<<(Stream &s, const std::set<T> &set) {
+        return writeSequentialContainer(s, set);
+    }
+
+    template <class Stream, class Key, class T, IfInputStream<Stream> = 0>
+    inline Stream &operator>>(Stream &s, std::unordered_map<Key, T> &hash) {
+        return readAssociativeContainer(s, hash);
+    }
+
+    template <class Stream, class Key, class T, IfOutputStream<Stream> = 0>
+    inline Stream &operator<<(Stream &s, const std::unordered_map<Key, T> &hash) {
+        return writeAssociativeContainer(s, hash);
+    }
+
+    template <class Stream, class Key, class T, IfInputStream<Stream> = 0>
+    inline Stream &operator>>(Stream &s, std::map<Key, T> &map) {
+        return readAssociativeContainer(s, map);
+    }
+
+    template <class Stream, class Key, class T, IfOutputStream<Stream> = 0>
+    inline Stream &operator<<(Stream &s, const std::map<Key, T> &map) {
+        return writeAssociativeContainer(s, map);
+    }
+
+    template <class Stream, class T1, class T2, IfInputStream<Stream> = 0>
+    inline Stream &operator>>(Stream &s, std::pair<T1, T2> &p) {
+        s >> p.first >> p.second;
+        return s;
+    }
+
+    template <class Stream, class T1, class T2, IfOutputStream<Stream> = 0>
+    inline Stream &operator<<(Stream &s, const std::pair<T1, T2> &p) {
+        s << p.first << p.second;
+        return s;
+    }
+
+}
+
+#endif // STREAM_H
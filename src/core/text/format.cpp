@@ -1,5 +1,7 @@
 #include "format.h"
 
+#include "stringtableview.h"
+
 namespace MTC {
 
     std::string formatText(const std::string &format, const std::vector<std::string> &args) {
@@ -16,16 +18,12 @@ namespace MTC {
     }
 
     std::vector<std::string> extractNullSeperatedStrings(const char *data, size_t size) {
+        StringTableView table(data, size);
+
         std::vector<std::string> res;
-        std::string part;
-        for (size_t i = 0; i < size; ++i) {
-            const auto &ch = data[i];
-            if (ch == '\0') {
-                res.push_back(part);
-                part.clear();
-                continue;
-            }
-            part += ch;
+        res.reserve(table.count());
+        for (const auto &str : table) {
+            res.emplace_back(str);
         }
         return res;
     }
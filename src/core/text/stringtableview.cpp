@@ -0,0 +1,20 @@
+#include "stringtableview.h"
+
+namespace MTC {
+
+    size_t StringTableView::count() const {
+        size_t res = 0;
+        auto str = _data.data();
+        auto end = str + _data.size();
+        while (str < end) {
+            auto nul = static_cast<const char *>(memchr(str, '\0', size_t(end - str)));
+            if (!nul) {
+                break;
+            }
+            ++res;
+            str = nul + 1;
+        }
+        return res;
+    }
+
+}
@@ -0,0 +1,158 @@
+#ifndef STRINGTABLEVIEW_H
+#define STRINGTABLEVIEW_H
+
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include <mtccore/mtccoreglobal.h>
+
+namespace MTC {
+
+    // Non-owning view of a table of NUL-terminated strings, such as an ELF string table.
+    // Iteration stops at the last NUL, bytes after it are only reachable through at().
+    class MTC_CORE_EXPORT StringTableView {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view *;
+            using reference = const std::string_view &;
+
+            const_iterator() = default;
+
+            inline reference operator*() const;
+            inline pointer operator->() const;
+            inline size_t offset() const;
+
+            inline const_iterator &operator++();
+            inline const_iterator operator++(int);
+
+            inline bool operator==(const const_iterator &other) const;
+            inline bool operator!=(const const_iterator &other) const;
+
+        private:
+            inline const_iterator(const StringTableView *table, size_t offset);
+
+            const StringTableView *_table = nullptr;
+            size_t _offset = 0;
+            std::string_view _current;
+
+            friend class StringTableView;
+        };
+
+    public:
+        StringTableView() = default;
+        inline StringTableView(const char *data, size_t size);
+        inline explicit StringTableView(std::string_view data);
+
+        inline const char *data() const;
+        inline size_t size() const;
+        inline bool isEmpty() const;
+
+        // String starting at the offset, empty if the offset is out of range. A string that is
+        // not terminated inside the table runs to its end.
+        inline std::string_view at(size_t offset) const;
+
+        inline const_iterator begin() const;
+        inline const_iterator end() const;
+
+        size_t count() const;
+
+    private:
+        std::string_view _data;
+    };
+
+    inline StringTableView::StringTableView(const char *data, size_t size) : _data(data, size) {
+    }
+
+    inline StringTableView::StringTableView(std::string_view data) : _data(data) {
+    }
+
+    inline const char *StringTableView::data() const {
+        return _data.data();
+    }
+
+    inline size_t StringTableView::size() const {
+        return _data.size();
+    }
+
+    inline bool StringTableView::isEmpty() const {
+        return _data.empty();
+    }
+
+    inline std::string_view StringTableView::at(size_t offset) const {
+        if (offset >= _data.size()) {
+            return {};
+        }
+        auto str = _data.data() + offset;
+        auto size = _data.size() - offset;
+        auto nul = static_cast<const char *>(memchr(str, '\0', size));
+        return {str, nul ? size_t(nul - str) : size};
+    }
+
+    inline StringTableView::const_iterator StringTableView::begin() const {
+        return const_iterator(this, 0);
+    }
+
+    inline StringTableView::const_iterator StringTableView::end() const {
+        return const_iterator(this, _data.size());
+    }
+
+    inline StringTableView::const_iterator::const_iterator(const StringTableView *table,
+                                                           size_t offset)
+        : _table(table), _offset(offset) {
+        auto size = _table->_data.size();
+        if (_offset >= size) {
+            _offset = size;
+            return;
+        }
+
+        auto str = _table->_data.data() + _offset;
+        auto nul = static_cast<const char *>(memchr(str, '\0', size - _offset));
+        if (!nul) {
+            // Unterminated tail
+            _offset = size;
+            return;
+        }
+        _current = {str, size_t(nul - str)};
+    }
+
+    inline StringTableView::const_iterator::reference
+        StringTableView::const_iterator::operator*() const {
+        return _current;
+    }
+
+    inline StringTableView::const_iterator::pointer
+        StringTableView::const_iterator::operator->() const {
+        return &_current;
+    }
+
+    inline size_t StringTableView::const_iterator::offset() const {
+        return _offset;
+    }
+
+    inline StringTableView::const_iterator &StringTableView::const_iterator::operator++() {
+        *this = const_iterator(_table, _offset + _current.size() + 1);
+        return *this;
+    }
+
+    inline StringTableView::const_iterator StringTableView::const_iterator::operator++(int) {
+        auto org = *this;
+        ++(*this);
+        return org;
+    }
+
+    inline bool StringTableView::const_iterator::operator==(const const_iterator &other) const {
+        return _offset == other._offset;
+    }
+
+    inline bool StringTableView::const_iterator::operator!=(const const_iterator &other) const {
+        return _offset != other._offset;
+    }
+
+}
+
+#endif // STRINGTABLEVIEW_H
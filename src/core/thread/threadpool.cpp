@@ -0,0 +1,160 @@
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MTC {
+
+    class WorkerQueue {
+    public:
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    class ThreadPool::Impl {
+    public:
+        std::vector<std::thread> threads;
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+        std::mutex mutex;
+        std::condition_variable taskAvailable;
+        std::condition_variable allDone;
+
+        std::atomic<size_t> queued = 0;
+        size_t unfinished = 0;
+        size_t nextQueue = 0;
+        bool stopping = false;
+
+        // Identifies the pool and queue of the calling thread if it is a worker
+        static thread_local Impl *currentPool;
+        static thread_local size_t currentIndex;
+
+        void push(size_t index, std::function<void()> task);
+        bool pop(size_t index, std::function<void()> &task);
+        void run(size_t index);
+    };
+
+    thread_local ThreadPool::Impl *ThreadPool::Impl::currentPool = nullptr;
+    thread_local size_t ThreadPool::Impl::currentIndex = 0;
+
+    void ThreadPool::Impl::push(size_t index, std::function<void()> task) {
+        // Count the task before publishing it, otherwise it may finish before being counted
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++queued;
+            ++unfinished;
+        }
+        {
+            auto &queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        taskAvailable.notify_one();
+    }
+
+    bool ThreadPool::Impl::pop(size_t index, std::function<void()> &task) {
+        // Newest task from the own queue first, it is the most likely to be cache-hot
+        {
+            auto &queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                --queued;
+                return true;
+            }
+        }
+
+        // Steal the oldest task from another queue
+        for (size_t i = 1; i < queues.size(); ++i) {
+            auto &queue = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThreadPool::Impl::run(size_t index) {
+        currentPool = this;
+        currentIndex = index;
+
+        std::function<void()> task;
+        while (true) {
+            if (pop(index, task)) {
+                task();
+                task = nullptr;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--unfinished == 0) {
+                    allDone.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || queued > 0; });
+            if (stopping && queued == 0) {
+                break;
+            }
+        }
+    }
+
+    ThreadPool::ThreadPool(int threadCount) : _impl(std::make_unique<Impl>()) {
+        if (threadCount <= 0) {
+            threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+        }
+
+        _impl->queues.reserve(threadCount);
+        for (int i = 0; i < threadCount; ++i) {
+            _impl->queues.emplace_back(std::make_unique<WorkerQueue>());
+        }
+
+        _impl->threads.reserve(threadCount);
+        for (int i = 0; i < threadCount; ++i) {
+            _impl->threads.emplace_back(&Impl::run, _impl.get(), size_t(i));
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_impl->mutex);
+            _impl->stopping = true;
+        }
+        _impl->taskAvailable.notify_all();
+
+        for (auto &thread : _impl->threads) {
+            thread.join();
+        }
+    }
+
+    int ThreadPool::threadCount() const {
+        return int(_impl->threads.size());
+    }
+
+    void ThreadPool::start(std::function<void()> task) {
+        size_t index;
+        if (Impl::currentPool == _impl.get()) {
+            index = Impl::currentIndex;
+        } else {
+            std::lock_guard<std::mutex> lock(_impl->mutex);
+            index = _impl->nextQueue++ % _impl->queues.size();
+        }
+        _impl->push(index, std::move(task));
+    }
+
+    void ThreadPool::waitForDone() {
+        std::unique_lock<std::mutex> lock(_impl->mutex);
+        _impl->allDone.wait(lock, [this]() { return _impl->unfinished == 0; });
+    }
+
+}
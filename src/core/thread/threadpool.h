@@ -0,0 +1,34 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <memory>
+#include <functional>
+
+#include <mtccore/mtccoreglobal.h>
+
+namespace MTC {
+
+    // Work-stealing pool, every worker owns a task queue and takes work from the others when
+    // its own queue runs dry. Tasks started from inside a worker go to that worker's queue.
+    class MTC_CORE_EXPORT ThreadPool {
+    public:
+        explicit ThreadPool(int threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+    public:
+        int threadCount() const;
+
+        void start(std::function<void()> task);
+        void waitForDone();
+
+    protected:
+        class Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif // THREADPOOL_H
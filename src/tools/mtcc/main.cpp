@@ -2,20 +2,44 @@
 
 #include <mtccore/elffile.h>
 
+namespace fs = std::filesystem;
+
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        std::cout << "mtcc <elf file>" << std::endl;
+        std::cout << "mtcc <elf file or directory>..." << std::endl;
         return 0;
     }
 
-    MTC::ElfFile elf;
-    if (!elf.load(argv[1])) {
-        std::cerr << elf.errorMessage() << std::endl;
-        return -1;
+    std::vector<fs::path> paths;
+    for (int i = 1; i < argc; ++i) {
+        fs::path path = argv[i];
+        std::error_code ec;
+        if (!fs::is_directory(path, ec)) {
+            paths.push_back(path);
+            continue;
+        }
+        for (const auto &entry : fs::recursive_directory_iterator(path, ec)) {
+            if (entry.is_regular_file(ec)) {
+                paths.push_back(entry.path());
+            }
+        }
     }
 
-    for (int i = 0; i < elf.sectionHeaderCount(); ++i) {
-        std::cout << elf.sectionHeader(i).name() << std::endl;
+    int ret = 0;
+    auto files = MTC::ElfFile::loadMany(paths, 0, MTC::ElfFile::MapFile);
+    for (const auto &elf : files) {
+        if (!elf.isValid()) {
+            std::cerr << elf.errorMessage() << std::endl;
+            ret = -1;
+            continue;
+        }
+
+        if (files.size() > 1) {
+            std::cout << elf.filePath().string() << ":" << std::endl;
+        }
+        for (const auto &section : elf.sections()) {
+            std::cout << section.name() << std::endl;
+        }
     }
-    return 0;
-}
\ No newline at end of file
+    return ret;
+}